@@ -4,6 +4,7 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
 using namespace std;
 
 #include <stdlib.h>
@@ -11,84 +12,134 @@ using namespace std;
 
 #include <GL/glew.h>
 
+#ifdef _WIN32
+#include <direct.h>
+#define MAKE_DIRECTORY(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define MAKE_DIRECTORY(path) mkdir(path, 0755)
+#endif
+
 #include "shader.hpp"
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+// Reads every active uniform or attribute of the program with the given glGetActive* call
+static std::vector<ShaderVariable> ReflectVariables(GLuint ProgramID, GLenum CountQuery, GLenum LengthQuery, bool Uniforms){
+	GLint Count = 0, MaxLength = 0;
+	glGetProgramiv(ProgramID, CountQuery, &Count);
+	glGetProgramiv(ProgramID, LengthQuery, &MaxLength);
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+	std::vector<ShaderVariable> Variables;
+	std::vector<char> Name(MaxLength + 1);
+	for (GLint i = 0; i < Count; i++){
+		ShaderVariable Variable;
+		GLsizei Length = 0;
+		if (Uniforms)
+			glGetActiveUniform(ProgramID, i, MaxLength, &Length, &Variable.size, &Variable.type, &Name[0]);
+		else
+			glGetActiveAttrib(ProgramID, i, MaxLength, &Length, &Variable.size, &Variable.type, &Name[0]);
+		Variable.name.assign(&Name[0], Length);
 
-	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if(VertexShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(VertexShaderStream, Line))
-			VertexShaderCode += "\n" + Line;
-		VertexShaderStream.close();
-	}else{
-		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
-		getchar();
-		return 0;
-	}
+		// Arrays are listed as "name[0]", they are looked up by their plain name
+		if (Variable.name.size() > 3 && Variable.name.compare(Variable.name.size() - 3, 3, "[0]") == 0)
+			Variable.name.resize(Variable.name.size() - 3);
 
-	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(FragmentShaderStream, Line))
-			FragmentShaderCode += "\n" + Line;
-		FragmentShaderStream.close();
+		Variable.location = Uniforms ? glGetUniformLocation(ProgramID, Variable.name.c_str()) : glGetAttribLocation(ProgramID, Variable.name.c_str());
+		// Members of uniform blocks have no location, they are set through the block's buffer
+		if (Variable.location < 0)
+			continue;
+		Variables.push_back(Variable);
 	}
+	return Variables;
+}
 
-	GLint Result = GL_FALSE;
-	int InfoLogLength;
+static GLint FindLocation(ShaderProgram & program, const std::vector<ShaderVariable> & Variables, const char * name, const char * Kind){
+	for (size_t i = 0; i < Variables.size(); i++){
+		if (Variables[i].name == name)
+			return Variables[i].location;
+	}
+	if (std::find(program.reported.begin(), program.reported.end(), name) == program.reported.end()){
+		printf("Program %u has no active %s \"%s\", setting it does nothing\n", program.id, Kind, name);
+		program.reported.push_back(name);
+	}
+	return -1;
+}
 
+GLint GetUniformLocation(ShaderProgram & program, const char * name){
+	return FindLocation(program, program.uniforms, name, "uniform");
+}
 
-	// Compile Vertex Shader
-	printf("Compiling shader : %s\n", vertex_file_path);
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
-	glCompileShader(VertexShaderID);
+GLint GetAttributeLocation(ShaderProgram & program, const char * name){
+	return FindLocation(program, program.attributes, name, "attribute");
+}
 
-	// Check Vertex Shader
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> VertexShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-		printf("%s\n", &VertexShaderErrorMessage[0]);
-	}
+bool BindUniformBlock(ShaderProgram & program, const char * name, GLuint binding){
+	GLuint BlockIndex = glGetUniformBlockIndex(program.id, name);
+	if (BlockIndex == GL_INVALID_INDEX)
+		return false;
+	glUniformBlockBinding(program.id, BlockIndex, binding);
+	return true;
+}
 
+// Puts the defines on the lines after #version, which has to stay the first statement
+static void InjectDefines(std::string & Code, const std::vector<std::string> & defines){
+	if (defines.empty())
+		return;
+	std::string Lines;
+	for (size_t i = 0; i < defines.size(); i++)
+		Lines += "\n#define " + defines[i] + " 1";
+	size_t Version = Code.find("#version");
+	size_t LineEnd = Version == std::string::npos ? 0 : Code.find('\n', Version);
+	Code.insert(LineEnd == std::string::npos ? Code.size() : LineEnd, Lines);
+}
 
+// The whole file in one read, false if it can't be opened. Also reads the cached binaries.
+static bool ReadShaderFile(const char * file_path, std::string & Code){
+	std::ifstream Stream(file_path, std::ios::in | std::ios::binary);
+	if (!Stream.is_open())
+		return false;
+	Stream.seekg(0, std::ios::end);
+	Code.resize((size_t)Stream.tellg());
+	Stream.seekg(0, std::ios::beg);
+	Stream.read(&Code[0], Code.size());
+	return true;
+}
 
-	// Compile Fragment Shader
-	printf("Compiling shader : %s\n", fragment_file_path);
-	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
-	glCompileShader(FragmentShaderID);
+// Compiles one stage, prints the log if there is one. Returns 0 if it did not compile.
+static GLuint CompileStage(GLenum Type, const char * file_path, const std::string & Code, const std::string & DefineList){
+	printf("Compiling shader : %s%s\n", file_path, DefineList.c_str());
+	GLuint ShaderID = glCreateShader(Type);
+	char const * SourcePointer = Code.c_str();
+	glShaderSource(ShaderID, 1, &SourcePointer , NULL);
+	glCompileShader(ShaderID);
 
-	// Check Fragment Shader
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	GLint Result = GL_FALSE;
+	int InfoLogLength;
+	glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Result);
+	glGetShaderiv(ShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 	if ( InfoLogLength > 0 ){
-		std::vector<char> FragmentShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-		printf("%s\n", &FragmentShaderErrorMessage[0]);
+		std::vector<char> ShaderErrorMessage(InfoLogLength+1);
+		glGetShaderInfoLog(ShaderID, InfoLogLength, NULL, &ShaderErrorMessage[0]);
+		printf("%s\n", &ShaderErrorMessage[0]);
 	}
+	if (Result != GL_TRUE){
+		glDeleteShader(ShaderID);
+		return 0;
+	}
+	return ShaderID;
+}
 
-
-
-	// Link the program
+// Links the stages into a new program, which is deleted again if linking fails
+static GLuint LinkProgram(const GLuint * ShaderIDs, int ShaderCount, bool Retrievable){
 	printf("Linking program\n");
 	GLuint ProgramID = glCreateProgram();
-	glAttachShader(ProgramID, VertexShaderID);
-	glAttachShader(ProgramID, FragmentShaderID);
+	if (Retrievable)
+		glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	for (int i = 0; i < ShaderCount; i++)
+		glAttachShader(ProgramID, ShaderIDs[i]);
 	glLinkProgram(ProgramID);
 
-	// Check the program
+	GLint Result = GL_FALSE;
+	int InfoLogLength;
 	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
 	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 	if ( InfoLogLength > 0 ){
@@ -97,14 +148,202 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 		printf("%s\n", &ProgramErrorMessage[0]);
 	}
 
-	
-	glDetachShader(ProgramID, VertexShaderID);
-	glDetachShader(ProgramID, FragmentShaderID);
-	
-	glDeleteShader(VertexShaderID);
-	glDeleteShader(FragmentShaderID);
+	for (int i = 0; i < ShaderCount; i++){
+		glDetachShader(ProgramID, ShaderIDs[i]);
+		glDeleteShader(ShaderIDs[i]);
+	}
+	if (Result != GL_TRUE){
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
+	return ProgramID;
+}
+
+// ---------------------------------------- Program binary cache ----------------------------------------
+// A linked program is stored as <directory>/<key>.bin: the GLenum binary format, then the binary.
+// The key hashes the final sources (defines included) and vendor, renderer and version of the driver,
+// so a changed shader or a driver update simply misses.
+
+static std::string CacheDirectory;
+static ShaderCacheStats CacheStats;
+
+void SetShaderCacheDirectory(const char * directory_path){
+	CacheDirectory = directory_path ? directory_path : "";
+	if (!CacheDirectory.empty())
+		MAKE_DIRECTORY(CacheDirectory.c_str());
+}
+
+ShaderCacheStats GetShaderCacheStats(){
+	return CacheStats;
+}
+
+static bool CacheUsable(){
+	if (CacheDirectory.empty() || !(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+		return false;
+	GLint Formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &Formats);
+	return Formats > 0;
+}
 
+// FNV-1a over the sources and the driver strings
+static std::string CacheKey(const std::string * Codes, int CodeCount){
+	unsigned long long Hash = 14695981039346656037ull;
+	std::string Driver;
+	const GLenum Names[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (int i = 0; i < 3; i++){
+		const GLubyte * Name = glGetString(Names[i]);
+		Driver += Name ? (const char *)Name : "";
+		Driver += '\0';
+	}
+	for (int i = 0; i <= CodeCount; i++){
+		const std::string & Part = i < CodeCount ? Codes[i] : Driver;
+		for (size_t k = 0; k < Part.size(); k++)
+			Hash = (Hash ^ (unsigned char)Part[k]) * 1099511628211ull;
+		Hash = (Hash ^ 0xFF) * 1099511628211ull;   // separator, so moving text between stages changes the key
+	}
+	char Key[17];
+	snprintf(Key, sizeof(Key), "%016llx", Hash);
+	return Key;
+}
+
+static std::string CachePath(const std::string & Key){
+	return CacheDirectory + "/" + Key + ".bin";
+}
+
+// A program from the cached binary, 0 if there is none or the driver rejects it
+static GLuint LoadCachedProgram(const std::string & Key){
+	std::string File;
+	GLenum Format = 0;
+	if (!ReadShaderFile(CachePath(Key).c_str(), File) || File.size() <= sizeof(Format))
+		return 0;
+	memcpy(&Format, File.data(), sizeof(Format));
+	const char * Binary = File.data() + sizeof(Format);
+	GLsizei BinaryLength = (GLsizei)(File.size() - sizeof(Format));
+
+	GLuint ProgramID = glCreateProgram();
+	glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glProgramBinary(ProgramID, Format, Binary, BinaryLength);
+	GLint Result = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	if (Result != GL_TRUE){
+		printf("Cached program %s was rejected by the driver, compiling it again\n", Key.c_str());
+		glDeleteProgram(ProgramID);
+		CacheStats.rejected++;
+		return 0;
+	}
 	return ProgramID;
 }
 
+static void StoreCachedProgram(const std::string & Key, GLuint ProgramID){
+	GLint Length = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &Length);
+	if (Length <= 0)
+		return;
+	std::vector<char> Binary(Length);
+	GLenum Format = 0;
+	glGetProgramBinary(ProgramID, Length, NULL, &Format, &Binary[0]);
+	std::ofstream Stream(CachePath(Key).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!Stream.is_open())
+		return;
+	Stream.write((const char *)&Format, sizeof(Format));
+	Stream.write(&Binary[0], Binary.size());
+}
+
+// Everything both loaders share: the cache lookup, otherwise compile and link the stages and store the result
+static ShaderProgram BuildProgram(const GLenum * Types, const char * const * file_paths, const std::string * Codes, int StageCount, const std::string & DefineList){
+	ShaderProgram Program;
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	bool UseCache = CacheUsable();
+	std::string Key = UseCache ? CacheKey(Codes, StageCount) : std::string();
+
+	GLuint ProgramID = UseCache ? LoadCachedProgram(Key) : 0;
+	if (ProgramID != 0){
+		printf("Loaded program for %s%s from the cache\n", file_paths[StageCount - 1], DefineList.c_str());
+		CacheStats.hits++;
+	}else{
+		GLuint ShaderIDs[2];
+		int Compiled = 0;
+		for (int i = 0; i < StageCount; i++){
+			GLuint ShaderID = CompileStage(Types[i], file_paths[i], Codes[i], DefineList);
+			if (ShaderID != 0)
+				ShaderIDs[Compiled++] = ShaderID;
+		}
+		ProgramID = Compiled == StageCount ? LinkProgram(ShaderIDs, Compiled, UseCache) : 0;
+		if (Compiled != StageCount){
+			for (int i = 0; i < Compiled; i++)
+				glDeleteShader(ShaderIDs[i]);
+		}
+		if (ProgramID != 0 && UseCache)
+			StoreCachedProgram(Key, ProgramID);
+		CacheStats.compiled++;
+	}
+	CacheStats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	if (ProgramID == 0)
+		return Program;
+
+	Program.id = ProgramID;
+	Program.uniforms = ReflectVariables(ProgramID, GL_ACTIVE_UNIFORMS, GL_ACTIVE_UNIFORM_MAX_LENGTH, true);
+	Program.attributes = ReflectVariables(ProgramID, GL_ACTIVE_ATTRIBUTES, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, false);
+	printf("Program %u: %d active uniforms, %d active attributes\n", ProgramID, (int)Program.uniforms.size(), (int)Program.attributes.size());
+	return Program;
+}
+
+ShaderProgram LoadShaders(const char * vertex_file_path,const char * fragment_file_path, const std::vector<std::string> & defines){
+
+	// Read the Vertex and the Fragment Shader code from the files
+	std::string Codes[2];
+	if (!ReadShaderFile(vertex_file_path, Codes[0])){
+		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
+		getchar();
+		return ShaderProgram();
+	}
+	if (!ReadShaderFile(fragment_file_path, Codes[1])){
+		printf("Impossible to open %s. Are you in the right directory ?\n", fragment_file_path);
+		return ShaderProgram();
+	}
+
+	InjectDefines(Codes[0], defines);
+	InjectDefines(Codes[1], defines);
+	std::string DefineList;
+	for (size_t i = 0; i < defines.size(); i++)
+		DefineList += " " + defines[i];
+
+	const GLenum Types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const char * const Paths[2] = { vertex_file_path, fragment_file_path };
+	return BuildProgram(Types, Paths, Codes, 2, DefineList);
+}
+
 
+ShaderProgram & GetShaderVariant(ShaderVariants & variants, unsigned int feature_bits, bool * built){
+	std::map<unsigned int, ShaderProgram>::iterator Found = variants.programs.find(feature_bits);
+	if (built)
+		*built = Found == variants.programs.end();
+	if (Found != variants.programs.end())
+		return Found->second;
+
+	std::vector<std::string> Defines;
+	for (size_t i = 0; i < variants.features.size(); i++){
+		if (feature_bits & (1u << i))
+			Defines.push_back(variants.features[i]);
+	}
+	return variants.programs[feature_bits] = LoadShaders(variants.vertex_file_path.c_str(), variants.fragment_file_path.c_str(), Defines);
+}
+
+void DeleteShaderVariants(ShaderVariants & variants){
+	for (std::map<unsigned int, ShaderProgram>::iterator it = variants.programs.begin(); it != variants.programs.end(); ++it)
+		glDeleteProgram(it->second.id);
+	variants.programs.clear();
+}
+
+ShaderProgram LoadComputeShader(const char * compute_file_path){
+
+	// Read the Compute Shader code from the file
+	std::string Code;
+	if (!ReadShaderFile(compute_file_path, Code)){
+		printf("Impossible to open %s. Are you in the right directory ?\n", compute_file_path);
+		return ShaderProgram();
+	}
+
+	const GLenum Type = GL_COMPUTE_SHADER;
+	return BuildProgram(&Type, &compute_file_path, &Code, 1, "");
+}
@@ -1,6 +1,65 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path);
+#include <map>
+#include <string>
+#include <vector>
+
+// One active uniform or vertex attribute, as the linker reports it
+struct ShaderVariable {
+	std::string name;      // without a trailing [0] for arrays
+	GLint location;
+	GLenum type;
+	GLint size;            // number of array elements, 1 if it isn't an array
+};
+
+// A linked program and everything it uses, enumerated once right after linking
+struct ShaderProgram {
+	GLuint id = 0;
+	std::vector<ShaderVariable> uniforms;
+	std::vector<ShaderVariable> attributes;
+	std::vector<std::string> reported;   // names that were asked for but don't exist, each is printed only once
+};
+
+// Every name in defines is set with "#define NAME 1" right after the #version line of both shaders
+ShaderProgram LoadShaders(const char * vertex_file_path,const char * fragment_file_path, const std::vector<std::string> & defines = std::vector<std::string>());
+
+// The programs built from the same two files with different sets of #defines. Shaders test the features
+// with #ifdef, so a variant only contains the code it needs and nothing branches on a uniform at runtime.
+struct ShaderVariants {
+	std::string vertex_file_path;
+	std::string fragment_file_path;
+	std::vector<std::string> features;                  // define of every feature bit, bit i sets features[i]
+	std::map<unsigned int, ShaderProgram> programs;     // by feature bits, each built the first time it is asked for
+};
+
+// Builds the variant the first time, later calls return the cached program. built tells which one it was.
+ShaderProgram & GetShaderVariant(ShaderVariants & variants, unsigned int feature_bits, bool * built = NULL);
+void DeleteShaderVariants(ShaderVariants & variants);
+
+// Linked programs are kept as driver binaries in this directory (created if missing) and loaded from there
+// on the next start, as long as sources and driver are the same. An empty path, or no binary format support, turns it off.
+void SetShaderCacheDirectory(const char * directory_path);
+
+// How the programs loaded so far were built, and the time it took (reading, compiling or loading, linking)
+struct ShaderCacheStats {
+	int hits = 0;          // loaded from a cached binary
+	int compiled = 0;      // compiled from source, also after a miss or a rejected binary
+	int rejected = 0;      // cached binaries the driver refused
+	double seconds = 0.0;
+};
+
+ShaderCacheStats GetShaderCacheStats();
+
+// Needs GL 4.3, check GLEW_VERSION_4_3 first. Returns a program with id 0 if the file can't be read or doesn't compile.
+ShaderProgram LoadComputeShader(const char * compute_file_path);
+
+// Look the location up once after loading and keep it, not every frame.
+// A name the program doesn't have (misspelled or optimized away) is reported once and gives -1, which glUniform* ignores.
+GLint GetUniformLocation(ShaderProgram & program, const char * name);
+GLint GetAttributeLocation(ShaderProgram & program, const char * name);
+
+// Points the program's uniform block at the buffer bound to the binding point. Returns false if the program has no such block.
+bool BindUniformBlock(ShaderProgram & program, const char * name, GLuint binding);
 
 #endif
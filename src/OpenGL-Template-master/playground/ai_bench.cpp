@@ -0,0 +1,126 @@
+//Benchmark for the enemy thinking on level 1 with many enemies, no window needed.
+//For every enemy count it runs the old loop (every enemy aims and tests its line of sight every update), then
+//thinkEnemies without a budget, with a limit of thinks per update and with a time budget. Without a budget no enemy
+//may wait longer than aiOffScreenInterval updates. Only the times and the time budget row depend on the machine.
+//usage: ai_bench [ticks] [budget us] [think limit]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "benchutil.hpp"
+#include "simulation.hpp"
+
+struct Timing {
+    double mean = 0.0, worst = 0.0;                 //microseconds per update
+};
+
+//what every update did before the scheduler
+static void thinkAllEnemies(std::vector<cube>& enemies, const cube& player, BulletPool& bullets, const WallGrid& wallGrid, float currentTime) {
+    for (cube& enemy : enemies) {
+        float deltaX = player.x - enemy.x;
+        float deltaZ = player.z - enemy.z;
+        enemy.rotation = glm::degrees(atan2(deltaX, -deltaZ));
+        if (hasLineOfSight(enemy, player, wallGrid) && (currentTime - enemy.lastShotTime) > enemy.shootCooldown) {
+            spawnBullet(bullets, enemy.x, enemy.z, enemy.rotation, bulletSpeed, 1, true);
+            enemy.lastShotTime = currentTime;
+        }
+    }
+}
+
+//the player walks a square around the round room and turns, bullets are dropped every update so the pool never fills
+static void movePlayer(GameState& game, int t) {
+    int side = t / 150 % 4;
+    float along = t % 150 / 15.0f;
+    game.player.x = side == 0 ? -30.0f + 6.0f * along : (side == 1 ? 30.0f : (side == 2 ? 30.0f - 6.0f * along : -30.0f));
+    game.player.z = side == 1 ? -30.0f + 6.0f * along : (side == 3 ? 30.0f - 6.0f * along : (side == 0 ? -30.0f : 30.0f));
+    game.player.rotation = 90.0f * side;
+    game.bullets.count = 0;
+}
+
+//mode 0: the old loop, 1: thinkEnemies without a budget, 2: with the think limit, 3: with the time budget.
+//Returns the enemies that waited too long
+static int run(const GameState& level, int mode, int ticks, double budget, int limit, Timing& timing, AiStats& totals) {
+    GameState game = level;
+    game.ai = AiScheduler();
+    game.ai.thinkLimit = mode == 2 ? limit : 0;
+    game.ai.budgetMicroseconds = mode == 3 ? budget : 0.0;
+    staggerEnemyThinking(game.enemies);
+    int late = 0;
+    double sum = 0.0;
+    for (int t = 0; t < ticks; ++t) {
+        movePlayer(game, t);
+        float currentTime = (float)(t / tickRate);
+        auto start = std::chrono::steady_clock::now();
+        if (mode == 0) {
+            thinkAllEnemies(game.enemies, game.player, game.bullets, game.wallGrid, currentTime);
+        }
+        else {
+            thinkEnemies(game.ai, game.enemies, game.player, game.cameraYaw, game.bullets, game.wallGrid, currentTime);
+        }
+        double microseconds = microsecondsSince(start);
+        sum += microseconds;
+        timing.worst = std::max(timing.worst, microseconds);
+        if (mode == 1) {
+            for (const cube& enemy : game.enemies) {
+                late += game.ai.tick - enemy.lastThought >= aiOffScreenInterval;
+            }
+        }
+        totals.thinks += game.ai.stats.thinks;
+        totals.lineOfSightTests += game.ai.stats.lineOfSightTests;
+        totals.reloading += game.ai.stats.reloading;
+        totals.deferred += game.ai.stats.deferred;
+    }
+    timing.mean = sum / ticks;
+    totals.updates = game.ai.stats.updates;
+    totals.overruns = game.ai.stats.overruns;
+    totals.stalenessSum = game.ai.stats.stalenessSum;
+    return late;
+}
+
+int main(int argc, char** argv) {
+    int ticks = argc > 1 ? std::atoi(argv[1]) : 600;
+    double budget = argc > 2 ? std::atof(argv[2]) : 200.0;
+    int limit = argc > 3 ? std::atoi(argv[3]) : 500;
+
+    GameState level;
+    startGame(level, 1, 1, 0.0);
+    Rng rng = seedRng(5);
+    const int counts[] = { 250, 1000, 4000, 16000 };
+    int late = 0;
+    printf("%d updates, limit %d thinks, budget %.0f us, times per update\n\n", ticks, limit, budget);
+    printf("%7s  %-12s %9s %9s %9s %9s %9s %9s %9s %9s\n", "enemies", "", "mean us", "worst us", "thinks", "los", "reloading", "deferred", "overruns", "staleness");
+    for (int count : counts) {
+        //enemies on random free cells of the platform, some already reloaded and some not
+        level.enemies.clear();
+        while ((int)level.enemies.size() < count) {
+            cube enemy = { (float)(randomInt(rng, 116) - 58), (float)(randomInt(rng, 116) - 58), 0.0f, 0.05f, 0.0f };
+            enemy.lastShotTime = -(float)randomInt(rng, 10);
+            if (wallCellAt(level.wallGrid, (int)enemy.x, (int)enemy.z) < 0) {
+                level.enemies.push_back(enemy);
+            }
+        }
+        const char* names[4] = { "every update", "scheduled", "think limit", "time budget" };
+        for (int mode = 0; mode < 4; ++mode) {
+            Timing timing;
+            AiStats totals;
+            int modeLate = run(level, mode, ticks, budget, limit, timing, totals);
+            late += modeLate;
+            if (mode == 0) {
+                printf("%7d  %-12s %9.1f %9.1f %9d %9s %9s %9s %9s %9s\n", count, names[mode], timing.mean, timing.worst, count, "all", "-", "-", "-", "0.00");
+                continue;
+            }
+            printf("%7s  %-12s %9.1f %9.1f %9.0f %9.0f %9.0f %9.0f %9d %9.2f%s\n", "", names[mode], timing.mean, timing.worst, (double)totals.thinks / ticks,
+                   (double)totals.lineOfSightTests / ticks, (double)totals.reloading / ticks, (double)totals.deferred / ticks, totals.overruns,
+                   totals.stalenessSum / std::max(totals.updates, 1), modeLate > 0 ? "  LATE" : "");
+        }
+    }
+    printf("\nper update: thinks, line of sight tests, thinks that skipped them while reloading, enemies left for the next update.\n");
+    printf("staleness: updates since an enemy last thought, averaged over enemies and updates\n");
+    printf("the time budget row changes from run to run, the others only in their times\n");
+    return late == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#ifndef BENCHUTIL_HPP
+#define BENCHUTIL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "frustum.hpp"
+#include "wallgrid.hpp"
+
+//Helpers the benchmarks and checks share: stopwatches, random floats and the reference tests
+//the culling results are checked against. Only meant for the bench and check executables.
+
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline double microsecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline float randomRange(float low, float high) {
+    return low + (high - low) * (std::rand() / (float)RAND_MAX);
+}
+
+//true if a wall column other than ignore is between the two points, walks every cell the segment crosses
+//and checks the lowest height the segment has inside the cell, so no corner is stepped over
+inline bool rayBlocked(const std::vector<wall>& walls, const WallGrid& grid, glm::vec3 from, glm::vec3 to, int ignore) {
+    glm::vec3 delta = to - from;
+    int cellX = (int)std::floor(from.x + 0.5f), cellZ = (int)std::floor(from.z + 0.5f);
+    int stepX = delta.x > 0.0f ? 1 : -1, stepZ = delta.z > 0.0f ? 1 : -1;
+    float tMaxX = delta.x != 0.0f ? (cellX + 0.5f * stepX - from.x) / delta.x : 2.0f;
+    float tMaxZ = delta.z != 0.0f ? (cellZ + 0.5f * stepZ - from.z) / delta.z : 2.0f;
+    float tDeltaX = delta.x != 0.0f ? 1.0f / std::abs(delta.x) : 2.0f;
+    float tDeltaZ = delta.z != 0.0f ? 1.0f / std::abs(delta.z) : 2.0f;
+    float tEnter = 0.0f;
+    while (tEnter < 1.0f) {
+        float tExit = std::min(1.0f, std::min(tMaxX, tMaxZ));
+        int w = wallCellAt(grid, cellX, cellZ);
+        if (w >= 0 && w != ignore && std::min(from.y + delta.y * tEnter, from.y + delta.y * tExit) < walls[w].h && tExit > tEnter) {
+            return true;
+        }
+        if (tMaxX < tMaxZ) {
+            cellX += stepX;
+            tMaxX += tDeltaX;
+        }
+        else {
+            cellZ += stepZ;
+            tMaxZ += tDeltaZ;
+        }
+        tEnter = tExit;
+    }
+    return false;
+}
+
+inline bool pointInFrustum(const Frustum& frustum, glm::vec3 p) {
+    for (int i = 0; i < 6; ++i) {
+        if (frustum.a[i] * p.x + frustum.b[i] * p.y + frustum.c[i] * p.z + frustum.d[i] < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include <cmath>
+
+#include "bullets.hpp"
+
+void initBulletPool(BulletPool& pool, int capacity) {
+    //the movement arrays get padding up to a multiple of 8 so moveBullets can run whole SIMD blocks
+    int padded = (capacity + 7) & ~7;
+    pool.count = 0;
+    pool.capacity = capacity;
+    pool.x.assign(padded, 0.0f);
+    pool.z.assign(padded, 0.0f);
+    pool.prevX.assign(padded, 0.0f);
+    pool.prevZ.assign(padded, 0.0f);
+    pool.vx.assign(padded, 0.0f);
+    pool.vz.assign(padded, 0.0f);
+    pool.bounce.assign(capacity, 0);
+    pool.enemy.assign(capacity, 0);
+}
+
+bool spawnBullet(BulletPool& pool, float x, float z, float rotation, float speed, int bounce, bool enemy) {
+    if (pool.count >= pool.capacity) {
+        return false;
+    }
+    int i = pool.count++;
+    float rad = rotation * 3.14159265f / 180.0f;
+    pool.x[i] = x;
+    pool.z[i] = z;
+    pool.prevX[i] = x;
+    pool.prevZ[i] = z;
+    pool.vx[i] = speed * std::sin(rad);             //same direction the rotation used to give every tick
+    pool.vz[i] = -speed * std::cos(rad);
+    pool.bounce[i] = bounce;
+    pool.enemy[i] = enemy;
+    return true;
+}
+
+void removeBullet(BulletPool& pool, int i) {
+    int last = --pool.count;
+    pool.x[i] = pool.x[last];
+    pool.z[i] = pool.z[last];
+    pool.prevX[i] = pool.prevX[last];
+    pool.prevZ[i] = pool.prevZ[last];
+    pool.vx[i] = pool.vx[last];
+    pool.vz[i] = pool.vz[last];
+    pool.bounce[i] = pool.bounce[last];
+    pool.enemy[i] = pool.enemy[last];
+}
+
+//restrict on the parameters tells the compiler the arrays never overlap, so it can use SIMD without checks
+static void advance(float* __restrict position, float* __restrict previous, const float* __restrict velocity, int count) {
+    for (int i = 0; i < count; ++i) {
+        previous[i] = position[i];
+        position[i] += velocity[i];
+    }
+}
+
+void moveBullets(BulletPool& pool) {
+    //bullets past count only live in the padding or are dead, moving them does no harm
+    int count = (pool.count + 7) & ~7;
+    advance(pool.x.data(), pool.prevX.data(), pool.vx.data(), count);
+    advance(pool.z.data(), pool.prevZ.data(), pool.vz.data(), count);
+}
+
+bool bounceBullet(BulletPool& pool, int i, const std::vector<wall>& walls, const WallGrid& wallGrid, float border) {
+    float x = pool.x[i];
+    float z = pool.z[i];
+    bool bounced = false;
+
+    //Checks collision with platform borders, flipping the rotation used to flip one velocity component
+    if (x <= -border || x >= border) {
+        pool.vx[i] = -pool.vx[i];
+        bounced = true;
+    }
+    if (z <= -border || z >= border) {
+        pool.vz[i] = -pool.vz[i];
+        bounced = true;
+    }
+
+    //checks for collisions with walls, only the cell the bullet is in can contain one
+    int hit = wallAtPoint(wallGrid, walls, x, z);
+    if (hit >= 0) {
+        float overlapX = std::abs(x - walls[hit].x);
+        float overlapZ = std::abs(z - walls[hit].z);
+        if (overlapX > overlapZ) {
+            pool.vx[i] = -pool.vx[i];
+        }
+        else {
+            pool.vz[i] = -pool.vz[i];
+        }
+        bounced = true;
+    }
+    return bounced;
+}
@@ -0,0 +1,26 @@
+#ifndef BULLETS_HPP
+#define BULLETS_HPP
+
+#include <vector>
+
+#include "wallgrid.hpp"
+
+//for bullets, kept as structure of arrays with a fixed capacity so shooting never allocates
+//and the movement loop can be vectorized
+struct BulletPool {
+    int count = 0;
+    int capacity = 0;
+    std::vector<float> x, z;
+    std::vector<float> prevX, prevZ;                //position before the last tick, for interpolated rendering
+    std::vector<float> vx, vz;                      //movement per tick, computed once when the bullet is shot
+    std::vector<int> bounce;                        //all bullets can collide with one wall and bounce instead of being destroyed
+    std::vector<char> enemy;                        //owner, so the shooter of the bullet doesnt instantly collide with his own bullet
+};
+
+void initBulletPool(BulletPool& pool, int capacity); //<<< allocates all arrays once
+bool spawnBullet(BulletPool& pool, float x, float z, float rotation, float speed, int bounce, bool enemy); //<<< false if the pool is full
+void removeBullet(BulletPool& pool, int i); //<<< O(1), the last bullet takes the place of bullet i
+void moveBullets(BulletPool& pool); //<<< remembers the old position and advances every bullet by its velocity
+bool bounceBullet(BulletPool& pool, int i, const std::vector<wall>& walls, const WallGrid& wallGrid, float border); //<<< reflects bullet i off the border or a wall, true if it bounced
+
+#endif
@@ -0,0 +1,73 @@
+//Benchmark for the bullet pool: keeps N bullets flying in a 120x120 arena with ~1k walls and
+//19 enemies and times one update tick (movement, border/wall bounces, enemy hits, removal).
+//Removed bullets are shot again right away so the count stays at N.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bullets.hpp"
+#include "wallgrid.hpp"
+
+struct point {
+    float x, z;
+};
+
+static float randomCoord(int half) {
+    return (float)(std::rand() % (2 * half * 100)) / 100.0f - half;
+}
+
+int main() {
+    const int ticks = 200;
+    int bulletCounts[] = { 1000, 10000, 50000 };
+
+    std::srand(1);
+    std::vector<wall> walls;
+    for (int i = 0; i < 1000; ++i) {
+        walls.push_back({ (float)(std::rand() % 120 - 60), (float)(std::rand() % 120 - 60), 5.0f });
+    }
+    WallGrid grid = buildWallGrid(walls);
+    std::vector<point> enemies(19);
+    for (point& e : enemies) e = { randomCoord(60), randomCoord(60) };
+
+    printf("%8s %12s %12s\n", "bullets", "ms/tick", "removed");
+    for (int bulletCount : bulletCounts) {
+        BulletPool pool;
+        initBulletPool(pool, bulletCount);
+        while (spawnBullet(pool, randomCoord(60), randomCoord(60), (float)(std::rand() % 360), 0.2f, 1, std::rand() % 2 == 0)) {}
+
+        long long removed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; ++t) {
+            moveBullets(pool);
+            int i = 0;
+            while (i < pool.count) {
+                bool remove = false;
+                if (bounceBullet(pool, i, walls, grid, 60.0f)) {
+                    remove = pool.bounce[i]-- == 0;
+                }
+                if (!pool.enemy[i]) {
+                    for (const point& e : enemies) {
+                        float dx = pool.x[i] - e.x, dz = pool.z[i] - e.z;
+                        if (dx * dx + dz * dz < 0.49f) {
+                            remove = true;
+                            break;
+                        }
+                    }
+                }
+                if (remove) {
+                    removeBullet(pool, i);
+                    removed++;
+                }
+                else {
+                    ++i;
+                }
+            }
+            while (spawnBullet(pool, randomCoord(60), randomCoord(60), (float)(std::rand() % 360), 0.2f, 1, std::rand() % 2 == 0)) {}
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ticks;
+        printf("%8d %12.3f %12lld\n", bulletCount, ms, removed / ticks);
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+
+#include "flowfield.hpp"
+
+int cellOf(float v) {
+    return (int)std::floor(v + 0.5f);
+}
+
+//index of the cell, -1 outside the field
+static int cellIndex(const FlowField& field, int cellX, int cellZ) {
+    int gx = cellX - field.minX;
+    int gz = cellZ - field.minZ;
+    if (gx < 0 || gz < 0 || gx >= field.width || gz >= field.depth) {
+        return -1;
+    }
+    return gz * field.width + gx;
+}
+
+void initFlowField(FlowField& field, const WallGrid& grid, float platformSize) {
+    //every cell whose center a tank can stand on (tanks are clamped half a unit inside the border),
+    //and a blocked ring around them so the search never has to check the edges
+    float border = platformSize / 2.0f - 0.5f;
+    field = FlowField();
+    field.minX = field.minZ = cellOf(-border) - 1;
+    field.width = field.depth = cellOf(border) - field.minX + 2;
+    field.blocked.assign(field.width * field.depth, 1);
+    for (int gz = 1; gz < field.depth - 1; ++gz) {
+        for (int gx = 1; gx < field.width - 1; ++gx) {
+            field.blocked[gz * field.width + gx] = wallCellAt(grid, field.minX + gx, field.minZ + gz) >= 0;
+        }
+    }
+    field.cleared.resize(field.blocked.size());
+    for (size_t i = 0; i < field.blocked.size(); ++i) {
+        field.cleared[i] = field.blocked[i] ? flowBlocked : flowUnreachable;
+    }
+    field.distance = field.cleared;
+    field.next.assign(field.blocked.size(), -1);
+    field.frontier.reserve(field.blocked.size());
+}
+
+//breadth first from the target over straight steps, then every cell picks its closest neighbour.
+//Walls are in the distances as flowBlocked, so each neighbour is one load and no wall is ever closer.
+//Diagonals are only taken if both straight cells beside them are free, so nothing cuts a wall corner.
+static void buildFlowField(FlowField& field, int target) {
+    int offset[8];
+    for (int n = 0; n < 8; ++n) {
+        offset[n] = flowNeighbourZ[n] * field.width + flowNeighbourX[n];
+    }
+    uint16_t* distance = field.distance.data();
+    std::copy(field.cleared.begin(), field.cleared.end(), field.distance.begin());
+    std::fill(field.next.begin(), field.next.end(), (int8_t)-1);
+    field.frontier.clear();
+    distance[target] = 0;
+    field.frontier.push_back(target);
+    for (size_t head = 0; head < field.frontier.size(); ++head) {
+        int cell = field.frontier[head];
+        uint16_t stepped = distance[cell] + 1;
+        for (int n = 0; n < 4; ++n) {
+            int neighbour = cell + offset[n];
+            if (distance[neighbour] == flowUnreachable) {
+                distance[neighbour] = stepped;
+                field.frontier.push_back(neighbour);
+            }
+        }
+    }
+
+    //only the reached cells need a direction, they are all in the frontier. Their straight neighbours are reached
+    //or walls, so a diagonal is free of corners if neither straight cell beside it is flowBlocked
+    for (int cell : field.frontier) {
+        uint16_t best = distance[cell];
+        int8_t next = -1;
+        for (int n = 0; n < 4; ++n) {
+            if (distance[cell + offset[n]] < best) {
+                best = distance[cell + offset[n]];
+                next = (int8_t)n;
+            }
+        }
+        for (int n = 4; n < 8; ++n) {
+            if (distance[cell + offset[n]] < best && distance[cell + flowNeighbourX[n]] != flowBlocked && distance[cell + flowNeighbourZ[n] * field.width] != flowBlocked) {
+                best = distance[cell + offset[n]];
+                next = (int8_t)n;
+            }
+        }
+        field.next[cell] = next;
+    }
+    field.rebuilds++;
+}
+
+bool updateFlowField(FlowField& field, float targetX, float targetZ) {
+    //a target pushed against the border still counts as its nearest cell inside
+    int cellX = std::min(std::max(cellOf(targetX), field.minX + 1), field.minX + field.width - 2);
+    int cellZ = std::min(std::max(cellOf(targetZ), field.minZ + 1), field.minZ + field.depth - 2);
+    if (field.built && cellX == field.targetX && cellZ == field.targetZ) {
+        return false;
+    }
+    field.targetX = cellX;
+    field.targetZ = cellZ;
+    field.built = true;
+    buildFlowField(field, cellIndex(field, cellX, cellZ));
+    return true;
+}
+
+bool flowStep(const FlowField& field, float x, float z, float& nextX, float& nextZ) {
+    int cellX = cellOf(x), cellZ = cellOf(z);
+    int cell = cellIndex(field, cellX, cellZ);
+    if (cell < 0 || field.next[cell] < 0) {
+        return false;
+    }
+    int n = field.next[cell];
+    nextX = (float)(cellX + flowNeighbourX[n]);
+    nextZ = (float)(cellZ + flowNeighbourZ[n]);
+    return true;
+}
+
+int flowDistance(const FlowField& field, float x, float z) {
+    int cell = cellIndex(field, cellOf(x), cellOf(z));
+    return cell < 0 || field.distance[cell] == flowBlocked ? flowUnreachable : field.distance[cell];
+}
+
+int flowCell(const FlowField& field, float x, float z) {
+    return cellIndex(field, cellOf(x), cellOf(z));
+}
+
+void clearOccupancy(FlowOccupancy& occupancy, const FlowField& field) {
+    if (occupancy.agent.size() != field.blocked.size()) {
+        occupancy.agent.assign(field.blocked.size(), -1);
+    }
+    else {
+        for (int cell : occupancy.taken) {
+            occupancy.agent[cell] = -1;
+        }
+    }
+    occupancy.taken.clear();
+}
+
+bool occupyCell(FlowOccupancy& occupancy, int cell, int agent) {
+    if (occupancy.agent[cell] >= 0 && occupancy.agent[cell] != agent) {
+        return false;
+    }
+    if (occupancy.agent[cell] < 0) {
+        occupancy.agent[cell] = agent;
+        occupancy.taken.push_back(cell);
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef FLOWFIELD_HPP
+#define FLOWFIELD_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "wallgrid.hpp"
+
+//Flow field toward one target cell, shared by everything that chases it. One breadth first pass from the target over
+//the free cells gives every cell its distance in steps, then every cell points at the neighbour closest to the target.
+//It is only rebuilt when the target moves into another cell, in between finding the way is one lookup per agent.
+
+const uint16_t flowUnreachable = 0xFFFF;
+const uint16_t flowBlocked = 0xFFFE;                //distance of wall cells, farther than any real one
+
+//the 8 neighbours of a cell, the 4 straight ones first
+const int flowNeighbourX[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+const int flowNeighbourZ[8] = { 0, 0, 1, -1, 1, 1, -1, -1 };
+
+struct FlowField {
+    int minX = 0, minZ = 0;                         //world coordinate of cell (0,0), cells are centered on integers like the wall grid
+    int width = 0, depth = 0;
+    std::vector<uint8_t> blocked;                   //1 for wall cells and the ring around the platform
+    std::vector<uint16_t> distance;                 //straight steps to the target, flowUnreachable if walls are in the way, flowBlocked in walls
+    std::vector<uint16_t> cleared;                  //distance before a search, every build starts from a copy
+    std::vector<int8_t> next;                       //neighbour one step closer, -1 at the target and where it can't be reached
+    std::vector<int> frontier;                      //queue of the search, kept allocated
+    int targetX = 0, targetZ = 0;                   //cell the field leads to
+    bool built = false;
+    int rebuilds = 0;                               //since initFlowField
+};
+
+//which agent stands in each cell of a field, so the agents following it can keep out of each other's cells.
+//Kept allocated, only the cells that were taken are cleared again
+struct FlowOccupancy {
+    std::vector<int> agent;                         //per cell of the field, -1 if free
+    std::vector<int> taken;                         //cells set since the last clearOccupancy
+};
+
+int cellOf(float v); //<<< world coordinate -> cell coordinate, cell k covers (k - 0.5, k + 0.5) like in the wall grid
+void initFlowField(FlowField& field, const WallGrid& grid, float platformSize); //<<< the cells of the platform, the walls of the grid are blocked
+bool updateFlowField(FlowField& field, float targetX, float targetZ); //<<< rebuilds only if the target is in another cell than last time, true if it did
+bool flowStep(const FlowField& field, float x, float z, float& nextX, float& nextZ); //<<< center of the next cell toward the target, false in the target cell or if it can't be reached
+int flowDistance(const FlowField& field, float x, float z); //<<< straight steps to the target, flowUnreachable in walls and outside the platform too
+int flowCell(const FlowField& field, float x, float z); //<<< index of the cell the point is in, -1 outside the field
+
+void clearOccupancy(FlowOccupancy& occupancy, const FlowField& field); //<<< every cell free, sized for the field
+bool occupyCell(FlowOccupancy& occupancy, int cell, int agent); //<<< false if another agent has the cell already
+
+#endif
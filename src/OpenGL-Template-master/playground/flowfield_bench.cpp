@@ -0,0 +1,215 @@
+//Benchmark for the chase flow field on level 1, no window needed.
+//Checks that from every cell the field reaches, following its steps leads into the target cell in exactly its distance
+//(a diagonal counts as two straight steps). Then it times rebuilding the field, moving many enemies along it, and the
+//per enemy A* search the field replaces. Enemies must never share a cell, also not when a wall pushes one out of the
+//cell it drove into.
+//usage: flowfield_bench [enemies] [ticks]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <vector>
+
+#include "benchutil.hpp"
+#include "simulation.hpp"
+
+//follows the field from every reached cell, the walk must end in the target after the cell's distance
+static int brokenCells(const FlowField& field) {
+    int broken = 0;
+    for (int gz = 0; gz < field.depth; ++gz) {
+        for (int gx = 0; gx < field.width; ++gx) {
+            uint16_t distance = field.distance[gz * field.width + gx];
+            if (distance >= flowBlocked) {
+                continue;
+            }
+            float x = (float)(field.minX + gx), z = (float)(field.minZ + gz);
+            int steps = 0;
+            float nextX, nextZ;
+            while (flowStep(field, x, z, nextX, nextZ) && steps <= distance) {
+                steps += nextX != x && nextZ != z ? 2 : 1;
+                x = nextX;
+                z = nextZ;
+            }
+            bool arrived = (int)x == field.targetX && (int)z == field.targetZ;
+            broken += !arrived || steps != distance;
+        }
+    }
+    return broken;
+}
+
+//enemies in a cell another one stands in, or in a cell the occupancy doesn't give to them
+static int crowdErrors(const std::vector<cube>& enemies, const FlowField& field, const FlowOccupancy& crowd) {
+    std::vector<int> perCell(field.width * field.depth, 0);
+    int errors = 0;
+    for (int i = 0; i < (int)enemies.size(); ++i) {
+        int cell = flowCell(field, enemies[i].x, enemies[i].z);
+        errors += perCell[cell]++ > 0 || crowd.agent[cell] != i;
+    }
+    return errors;
+}
+
+//A field built without a line of walls the enemies then collide with. The enemies are faster than half a cell, so a
+//step ends inside a wall cell and the push puts them back into the cell they came from or aside into another one.
+//On the generated levels the field knows every wall and a push keeps an enemy in its cell, this is the case where it doesn't.
+static int pushedAcrossCells(int& pushes) {
+    GameState game;
+    game.platformSize = 20.0f;
+    initFlowField(game.chase, buildWallGrid(game.walls), game.platformSize);
+    for (int z = -6; z <= 6; ++z) {
+        game.walls.push_back({ 0.0f, (float)z, 2.0f });
+    }
+    game.wallGrid = buildWallGrid(game.walls);
+    clearOccupancy(game.crowd, game.chase);
+    game.player = { -8.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int x = 1; x <= 6; ++x) {
+        for (int z = -4; z <= 4; ++z) {
+            game.enemies.push_back({ (float)x + 0.3f, (float)z - 0.2f, 0.0f, 0.6f, 0.0f });
+        }
+    }
+    updateFlowField(game.chase, game.player.x, game.player.z);
+    pushes = 0;
+    int errors = 0;
+    for (int t = 0; t < 120; ++t) {
+        //steps that end in a wall cell, the walls push those enemies out of it again
+        for (const cube& enemy : game.enemies) {
+            float nextX, nextZ;
+            if (flowStep(game.chase, enemy.x, enemy.z, nextX, nextZ)) {
+                float deltaX = nextX - enemy.x, deltaZ = nextZ - enemy.z;
+                float length = sqrt(deltaX * deltaX + deltaZ * deltaZ);
+                float step = std::min(enemy.speed, length);
+                float x = enemy.x + deltaX / length * step, z = enemy.z + deltaZ / length * step;
+                pushes += wallCellAt(game.wallGrid, (int)std::floor(x + 0.5f), (int)std::floor(z + 0.5f)) >= 0;
+            }
+        }
+        moveEnemies(game.enemies, game.player, game.chase, game.crowd, game.walls, game.wallGrid, game.platformSize);
+        errors += crowdErrors(game.enemies, game.chase, game.crowd);
+    }
+    return errors;
+}
+
+//what every enemy would do without the field: its own A* over the same cells and the same 8 moves
+static int astarLength(const FlowField& field, int fromX, int fromZ) {
+    struct Open {
+        int f, cell;
+        bool operator<(const Open& other) const { return f > other.f; }
+    };
+    static std::vector<int> cost;
+    cost.assign(field.blocked.size(), 1 << 30);
+    std::priority_queue<Open> open;
+    int target = (field.targetZ - field.minZ) * field.width + (field.targetX - field.minX);
+    int start = (fromZ - field.minZ) * field.width + (fromX - field.minX);
+    auto heuristic = [&](int cell) {
+        int dx = std::abs(cell % field.width - (field.targetX - field.minX));
+        int dz = std::abs(cell / field.width - (field.targetZ - field.minZ));
+        return 2 * std::max(dx, dz) + std::min(dx, dz);  //straight 2, diagonal 3
+    };
+    cost[start] = 0;
+    open.push({ heuristic(start), start });
+    while (!open.empty()) {
+        Open top = open.top();
+        open.pop();
+        if (top.cell == target) {
+            return cost[target];
+        }
+        if (top.f - heuristic(top.cell) > cost[top.cell]) {
+            continue;
+        }
+        int gx = top.cell % field.width, gz = top.cell / field.width;
+        for (int n = 0; n < 8; ++n) {
+            int nx = gx + flowNeighbourX[n], nz = gz + flowNeighbourZ[n];
+            if (nx < 0 || nz < 0 || nx >= field.width || nz >= field.depth || field.blocked[nz * field.width + nx]) {
+                continue;
+            }
+            if (n >= 4 && (field.blocked[gz * field.width + nx] || field.blocked[nz * field.width + gx])) {
+                continue;
+            }
+            int neighbour = nz * field.width + nx;
+            int stepped = cost[top.cell] + (n < 4 ? 2 : 3);
+            if (stepped < cost[neighbour]) {
+                cost[neighbour] = stepped;
+                open.push({ stepped + heuristic(neighbour), neighbour });
+            }
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char** argv) {
+    int enemyCount = argc > 1 ? std::atoi(argv[1]) : 4000;
+    int ticks = argc > 2 ? std::atoi(argv[2]) : 600;
+
+    GameState game;
+    startGame(game, 1, 1, 0.0);
+    FlowField& field = game.chase;
+    Rng rng = seedRng(7);
+
+    //targets on random free cells, each one has to give a working field
+    const int targets = 200;
+    int broken = 0, reachable = 0;
+    auto start = std::chrono::steady_clock::now();
+    double buildSeconds = 0.0;
+    for (int i = 0; i < targets; ++i) {
+        float x, z;
+        do {
+            x = (float)(field.minX + randomInt(rng, field.width));
+            z = (float)(field.minZ + randomInt(rng, field.depth));
+        } while (wallCellAt(game.wallGrid, (int)x, (int)z) >= 0);
+        start = std::chrono::steady_clock::now();
+        updateFlowField(field, x, z);
+        buildSeconds += secondsSince(start);
+        broken += brokenCells(field);
+        reachable += (int)field.frontier.size();
+    }
+    printf("%d targets: %.0f of %d cells reachable on average, %d cells lead the wrong way\n", targets, (double)reachable / targets, field.width * field.depth, broken);
+    printf("rebuild: %.1f us\n\n", buildSeconds / targets * 1e6);
+
+    //enemies on random reachable cells around the level, one per cell, the player walks a square so its cell keeps changing
+    updateFlowField(field, 0.0f, -50.0f);
+    game.enemies.clear();
+    std::vector<char> placed(field.width * field.depth, 0);
+    while ((int)game.enemies.size() < enemyCount) {
+        cube enemy = { (float)(field.minX + randomInt(rng, field.width)), (float)(field.minZ + randomInt(rng, field.depth)), 0.0f, 0.05f, 0.0f };
+        int cell = flowCell(field, enemy.x, enemy.z);
+        if (flowDistance(field, enemy.x, enemy.z) != flowUnreachable && !placed[cell]) {
+            placed[cell] = 1;
+            game.enemies.push_back(enemy);
+        }
+    }
+    int rebuildsBefore = field.rebuilds;
+    double moveSeconds = 0.0;
+    for (int t = 0; t < ticks; ++t) {
+        int side = t / 150 % 4;
+        game.player.x = side == 0 ? -5.0f + t % 150 / 15.0f : (side == 1 ? 5.0f : (side == 2 ? 5.0f - t % 150 / 15.0f : -5.0f));
+        game.player.z = side == 1 ? -5.0f + t % 150 / 15.0f : (side == 3 ? 5.0f - t % 150 / 15.0f : (side == 0 ? -5.0f : 5.0f));
+        start = std::chrono::steady_clock::now();
+        updateFlowField(field, game.player.x, game.player.z);
+        moveEnemies(game.enemies, game.player, field, game.crowd, game.walls, game.wallGrid, game.platformSize);
+        moveSeconds += secondsSince(start);
+    }
+    int rebuilds = field.rebuilds - rebuildsBefore;
+    double closer = 0.0;
+    for (const cube& enemy : game.enemies) {
+        closer += flowDistance(field, enemy.x, enemy.z);
+    }
+    int sharing = crowdErrors(game.enemies, field, game.crowd);
+    printf("%d enemies chasing for %d ticks: %d rebuilds, %.1f us per tick (%.0f ns per enemy), %.1f steps from the player on average\n",
+           enemyCount, ticks, rebuilds, moveSeconds / ticks * 1e6, moveSeconds / ticks / enemyCount * 1e9, closer / enemyCount);
+    printf("%d enemies ended in a cell another one stands in or that is not its own\n", sharing);
+    int pushes;
+    int pushedSharing = pushedAcrossCells(pushes);
+    printf("walls the field doesn't know: %d steps into a wall cell were pushed out, %d times an enemy stood in a cell that was not its own\n", pushes, pushedSharing);
+
+    //the same enemies each searching their own way once
+    const int searches = std::min(enemyCount, 500);
+    start = std::chrono::steady_clock::now();
+    int found = 0;
+    for (int i = 0; i < searches; ++i) {
+        found += astarLength(field, (int)std::floor(game.enemies[i].x + 0.5f), (int)std::floor(game.enemies[i].z + 0.5f)) >= 0;
+    }
+    double searchSeconds = secondsSince(start) / searches;
+    printf("A* per enemy: %.1f us each (%d/%d found a way), %.2f ms for all %d every time the player changes cells\n", searchSeconds * 1e6, found, searches,
+           searchSeconds * enemyCount * 1e3, enemyCount);
+    return broken == 0 && sharing == 0 && pushedSharing == 0 ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+#include "frustum.hpp"
+
+//Gribb & Hartmann: every plane is the last row of the matrix plus or minus one of the others
+Frustum extractFrustum(const float* m) {
+    Frustum frustum;
+    auto row = [m](int r, int column) { return m[column * 4 + r]; };
+    const int rows[6] = { 0, 0, 1, 1, 2, 2 };
+    const float signs[6] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+    for (int p = 0; p < 6; ++p) {
+        float plane[4];
+        for (int column = 0; column < 4; ++column) {
+            plane[column] = row(3, column) + signs[p] * row(rows[p], column);
+        }
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        frustum.a[p] = plane[0] / length;
+        frustum.b[p] = plane[1] / length;
+        frustum.c[p] = plane[2] / length;
+        frustum.d[p] = plane[3] / length;
+    }
+    return frustum;
+}
+
+bool boxVisible(const Frustum& frustum, const float boxMin[3], const float boxMax[3]) {
+    //the corner furthest along the plane normal decides, if even that one is behind the plane the box is outside
+    for (int p = 0; p < 6; ++p) {
+        float x = frustum.a[p] >= 0.0f ? boxMax[0] : boxMin[0];
+        float y = frustum.b[p] >= 0.0f ? boxMax[1] : boxMin[1];
+        float z = frustum.c[p] >= 0.0f ? boxMax[2] : boxMin[2];
+        if (frustum.a[p] * x + frustum.b[p] * y + frustum.c[p] * z + frustum.d[p] < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int cullBoxes(const Frustum& frustum, const float* x, const float* z, int count, float centerY, const float halfSize[3], int* visible) {
+    //per plane: distance of the center plus how far the box reaches towards the plane, |a| hx + |b| hy + |c| hz
+    float offset[6], reach[6];
+    for (int p = 0; p < 6; ++p) {
+        offset[p] = frustum.b[p] * centerY + frustum.d[p];
+        reach[p] = std::abs(frustum.a[p]) * halfSize[0] + std::abs(frustum.b[p]) * halfSize[1] + std::abs(frustum.c[p]) * halfSize[2];
+    }
+
+    int visibleCount = 0;
+    int i = 0;
+#ifdef FRUSTUM_SSE
+    //4 boxes at once, one plane after the other
+    for (; i + 4 <= count; i += 4) {
+        __m128 boxX = _mm_loadu_ps(x + i);
+        __m128 boxZ = _mm_loadu_ps(z + i);
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.a[p]), boxX), _mm_mul_ps(_mm_set1_ps(frustum.c[p]), boxZ));
+            distance = _mm_add_ps(distance, _mm_set1_ps(offset[p] + reach[p]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+        int mask = ~_mm_movemask_ps(outside) & 0xF;
+        while (mask) {
+            int lane = 0;
+            while (!(mask & (1 << lane))) {
+                lane++;
+            }
+            visible[visibleCount++] = i + lane;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p) {
+            inside = frustum.a[p] * x[i] + frustum.c[p] * z[i] + offset[p] + reach[p] >= 0.0f;
+        }
+        if (inside) {
+            visible[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
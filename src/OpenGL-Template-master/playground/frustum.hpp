@@ -0,0 +1,22 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+//View frustum culling, no GL so it also runs in the benchmarks.
+//A point is inside when a * x + b * y + c * z + d >= 0 for all six planes.
+struct Frustum {
+    float a[6], b[6], c[6], d[6];                   //left, right, bottom, top, near, far
+};
+
+//what one frame's culling kept and dropped
+struct CullStats {
+    int chunksVisible = 0, chunksTotal = 0;
+    int enemiesVisible = 0, enemiesTotal = 0;
+    int bulletsVisible = 0, bulletsTotal = 0;
+    int roomsVisible = 0, roomsTotal = 0;           //rooms reached through portals, the arena around them counts as one
+};
+
+Frustum extractFrustum(const float* viewProjection); //<<< planes of projection * view, column major like glm::value_ptr
+bool boxVisible(const Frustum& frustum, const float boxMin[3], const float boxMax[3]); //<<< false only if the box is completely outside one plane
+int cullBoxes(const Frustum& frustum, const float* x, const float* z, int count, float centerY, const float halfSize[3], int* visible); //<<< boxes of the same size centered on (x[i], centerY, z[i]), writes the indices of the visible ones and returns how many
+
+#endif
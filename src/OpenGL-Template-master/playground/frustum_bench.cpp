@@ -0,0 +1,91 @@
+//Benchmark for the frustum culling: a first person camera like the game's (70 degrees, far plane 100)
+//in the middle of a growing arena, culling bullets and baked wall chunks.
+//The SSE box test is compared with testing every box on its own.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "frustum.hpp"
+#include "wallmesh.hpp"
+
+static float randomCoord(int half) {
+    return (float)(std::rand() % (2 * half * 100)) / 100.0f - half;
+}
+
+int main() {
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), 2560.0f / 1440.0f, 0.1f, 100.0f);
+    glm::vec3 camera(0.0f, 2.0f, 0.0f);
+    glm::mat4 view = glm::lookAt(camera, camera + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = extractFrustum(glm::value_ptr(projection * view));
+    const float bulletHalf[3] = { 0.1f, 0.1f, 0.1f };
+    const int rounds = 100;
+
+    printf("%8s %8s %10s %10s %12s %12s %8s\n", "bullets", "arena", "visible", "culled", "sse us", "scalar us", "equal");
+    int counts[] = { 1000, 10000, 100000 };
+    for (int count : counts) {
+        std::srand(1);
+        //bullet density of 1000 bullets on the 120x120 platform
+        int half = (int)(60.0f * std::sqrt(count / 1000.0f));
+        std::vector<float> x(count), z(count);
+        for (int i = 0; i < count; ++i) {
+            x[i] = randomCoord(half);
+            z[i] = randomCoord(half);
+        }
+        std::vector<int> visible(count);
+
+        int visibleCount = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            visibleCount = cullBoxes(frustum, x.data(), z.data(), count, 0.5f, bulletHalf, visible.data());
+        }
+        double sseTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+        int scalarCount = 0;
+        std::vector<char> scalarVisible(count);
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            scalarCount = 0;
+            for (int i = 0; i < count; ++i) {
+                const float boxMin[3] = { x[i] - 0.1f, 0.4f, z[i] - 0.1f };
+                const float boxMax[3] = { x[i] + 0.1f, 0.6f, z[i] + 0.1f };
+                scalarVisible[i] = boxVisible(frustum, boxMin, boxMax);
+                scalarCount += scalarVisible[i];
+            }
+        }
+        double scalarTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+        bool equal = visibleCount == scalarCount;
+        for (int i = 0; i < visibleCount && equal; ++i) {
+            equal = scalarVisible[visible[i]] != 0;
+        }
+        printf("%8d %8d %10d %10d %12.1f %12.1f %8s\n", count, 2 * half, visibleCount, count - visibleCount, sseTime, scalarTime, equal ? "yes" : "NO");
+    }
+
+    //walls baked into chunks, how much of the mesh is left after culling
+    printf("\n%8s %8s %10s %10s %12s\n", "walls", "arena", "chunks", "drawn", "triangles");
+    int wallCounts[] = { 1000, 10000, 100000 };
+    for (int wallCount : wallCounts) {
+        std::srand(2);
+        int half = (int)(std::sqrt(wallCount / 0.07f) / 2.0f);
+        std::vector<wall> walls;
+        for (int i = 0; i < wallCount; ++i) {
+            walls.push_back({ (float)(std::rand() % (2 * half) - half), (float)(std::rand() % (2 * half) - half), 5.0f });
+        }
+        WallMesh mesh = bakeWallMesh(walls);
+        int drawn = 0, triangles = 0;
+        for (const WallChunk& chunk : mesh.chunks) {
+            if (boxVisible(frustum, chunk.boxMin, chunk.boxMax)) {
+                drawn++;
+                triangles += chunk.indexCount / 3;
+            }
+        }
+        printf("%8d %8d %10d %10d %5d of %d\n", wallCount, 2 * half, (int)mesh.chunks.size(), drawn, triangles, (int)mesh.indices.size() / 3);
+    }
+    return 0;
+}
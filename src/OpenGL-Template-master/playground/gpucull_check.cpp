@@ -0,0 +1,224 @@
+//Checks the GPU culling path against the CPU frustum test, without showing a window.
+//Runs on any GL 4.3 driver, also Mesa's llvmpipe on machines without a GPU:
+//    LIBGL_ALWAYS_SOFTWARE=1 ./gpucull_check          (from the playground directory, it loads the shaders from there)
+//For random views over level 1 with many enemies and bullets it reads the draw commands and visible instances
+//back and compares them with boxVisible, then draws them once through the drawIndirect packets of the render queue
+//like the game does.
+//Exits with 77 (skipped) if there is no GL 4.3 context, 1 if anything differs.
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "benchutil.hpp"
+#include "hiddencontext.hpp"
+#include "gpuculling.hpp"
+#include "renderqueue.hpp"
+#include "simulation.hpp"
+
+//same as CubeInstance in playground.cpp
+struct CheckInstance {
+    glm::vec3 position;
+    float yaw;
+    glm::vec3 scale;
+    glm::vec4 color;
+};
+
+//attributes 2-4 advance once per instance, the render queue points them at a buffer before every draw
+static void enableInstanceAttributes(GLuint vao) {
+    glBindVertexArray(vao);
+    for (int attribute = 2; attribute <= 4; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+}
+
+//same as pointInstanceAttributes in playground.cpp
+static void pointInstanceAttributes(GLuint buffer, int first) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    const char* base = (const char*)(first * sizeof(CheckInstance));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CheckInstance), base + offsetof(CheckInstance, position));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(CheckInstance), base + offsetof(CheckInstance, scale));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(CheckInstance), base + offsetof(CheckInstance, color));
+}
+
+static GLuint meshVAO(const float* positions, size_t positionCount, const unsigned int* indices, size_t indexCount) {
+    GLuint vao, vbo, ebo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, positionCount * sizeof(float), positions, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    return vao;
+}
+
+static bool sameInstance(const CheckInstance& a, const CheckInstance& b) {
+    return a.position == b.position && a.yaw == b.yaw && a.scale == b.scale && a.color == b.color;
+}
+
+int main() {
+    if (!glfwInit()) {
+        printf("no GLFW, skipped\n");
+        return 77;
+    }
+    if (!createHiddenContext(4, 3, "gpucull_check", 640, 360)) {
+        printf("no GL 4.3 context, skipped\n");
+        glfwTerminate();
+        return 77;
+    }
+    printf("%s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+    GameState game;
+    startGame(game, 1, 1, 0.0);
+    WallMesh mesh = bakeWallMesh(game.walls);
+    GpuCulling culling;
+    if (!setupGpuCulling(culling, mesh.chunks, sizeof(CheckInstance) / sizeof(float))) {
+        glfwTerminate();
+        return 77;
+    }
+
+    //many more tanks and bullets than a level has, spread over the whole platform
+    const int enemyCount = 5000, bulletCount = 20000;
+    std::srand(6);
+    std::vector<CheckInstance> instances;
+    for (int i = 0; i < enemyCount + bulletCount; ++i) {
+        bool enemy = i < enemyCount;
+        instances.push_back({ glm::vec3(randomRange(-60.0f, 60.0f), 0.5f, randomRange(-60.0f, 60.0f)), enemy ? randomRange(0.0f, 6.283f) : 0.0f,
+                              glm::vec3(enemy ? 1.0f : 0.2f), glm::vec4(enemy ? 0.4f : 1.0f, 0.2f, 0.2f, 1.0f) });
+    }
+    CullGroup groups[2];
+    groups[0].first = 0;
+    groups[0].count = enemyCount;
+    std::fill(groups[0].halfSize, groups[0].halfSize + 3, 0.71f);
+    groups[0].halfSize[1] = 0.5f;
+    groups[1].first = enemyCount;
+    groups[1].count = bulletCount;
+    std::fill(groups[1].halfSize, groups[1].halfSize + 3, 0.1f);
+
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), 2560.0f / 1440.0f, 0.1f, 100.0f);
+    const int views = 50;
+    int wrongChunks = 0, wrongInstances = 0, visibleChunks = 0, visibleInstances = 0;
+    double gpuTime = 0.0, cpuTime = 0.0;
+    for (int v = 0; v < views; ++v) {
+        glm::vec3 eye(randomRange(-59.0f, 59.0f), 2.0f, randomRange(-59.0f, 59.0f));
+        float yaw = randomRange(0.0f, 6.283f);
+        glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(sin(yaw), 0.0f, -cos(yaw)), glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum = extractFrustum(glm::value_ptr(projection * view));
+
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        runGpuCulling(culling, frustum, &instances[0].position.x, groups, 2);
+        glFinish();
+        gpuTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        //what the CPU path would keep
+        start = std::chrono::steady_clock::now();
+        std::vector<char> chunkVisible(mesh.chunks.size());
+        for (size_t c = 0; c < mesh.chunks.size(); ++c) {
+            chunkVisible[c] = boxVisible(frustum, mesh.chunks[c].boxMin, mesh.chunks[c].boxMax);
+        }
+        std::vector<CheckInstance> expected[2];
+        for (int g = 0; g < 2; ++g) {
+            for (int i = groups[g].first; i < groups[g].first + groups[g].count; ++i) {
+                const glm::vec3& p = instances[i].position;
+                const float boxMin[3] = { p.x - groups[g].halfSize[0], p.y - groups[g].halfSize[1], p.z - groups[g].halfSize[2] };
+                const float boxMax[3] = { p.x + groups[g].halfSize[0], p.y + groups[g].halfSize[1], p.z + groups[g].halfSize[2] };
+                if (boxVisible(frustum, boxMin, boxMax)) {
+                    expected[g].push_back(instances[i]);
+                }
+            }
+        }
+        cpuTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<DrawCommand> wallCommands(mesh.chunks.size());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.wallCommands);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, wallCommands.size() * sizeof(DrawCommand), wallCommands.data());
+        for (size_t c = 0; c < mesh.chunks.size(); ++c) {
+            wrongChunks += (wallCommands[c].instanceCount != 0) != (chunkVisible[c] != 0);
+            visibleChunks += wallCommands[c].instanceCount;
+        }
+
+        //the shader appends in any order, so both sides are compared as sets
+        DrawCommand cubeCommands[2];
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.cubeCommands);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(cubeCommands), cubeCommands);
+        std::vector<CheckInstance> written(instances.size());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.visibleInstances);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, written.size() * sizeof(CheckInstance), written.data());
+        auto byPosition = [](const CheckInstance& a, const CheckInstance& b) {
+            return a.position.x < b.position.x || (a.position.x == b.position.x && a.position.z < b.position.z);
+        };
+        for (int g = 0; g < 2; ++g) {
+            auto first = written.begin() + cubeCommands[g].baseInstance;
+            std::vector<CheckInstance> got(first, first + std::min<size_t>(cubeCommands[g].instanceCount, groups[g].count));
+            std::sort(got.begin(), got.end(), byPosition);
+            std::sort(expected[g].begin(), expected[g].end(), byPosition);
+            bool same = got.size() == expected[g].size() && std::equal(got.begin(), got.end(), expected[g].begin(), sameInstance);
+            wrongInstances += same ? 0 : std::max<int>(1, std::abs((int)got.size() - (int)expected[g].size()));
+            visibleInstances += (int)cubeCommands[g].instanceCount;
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    //one frame through the indirect packets of the render queue, the way drawSceneGpuCulled submits them.
+    //Nothing is looked at but the draw calls made and the GL errors
+    ShaderProgram program = LoadShaders("SimpleVertexShader.vertexshader", "SimpleFragmentShader.fragmentshader");
+    const float cubeVertices[] = { -0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f,
+                                   -0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f };
+    const unsigned int cubeIndices[] = { 0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4, 0, 4, 7, 7, 3, 0,
+                                         1, 5, 6, 6, 2, 1, 3, 2, 6, 6, 7, 3, 0, 1, 5, 5, 4, 0 };
+    GLuint cubeVAO = meshVAO(cubeVertices, 24, cubeIndices, 36);
+    GLuint wallVAO = meshVAO(mesh.positions.data(), mesh.positions.size(), mesh.indices.data(), mesh.indices.size());
+    CheckInstance wallInstance = { glm::vec3(0.0f), 0.0f, glm::vec3(1.0f), glm::vec4(0.54f, 0.27f, 0.07f, 1.0f) };
+    GLuint wallInstanceBuffer;
+    glGenBuffers(1, &wallInstanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, wallInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(wallInstance), &wallInstance, GL_STATIC_DRAW);
+    enableInstanceAttributes(wallVAO);
+    enableInstanceAttributes(cubeVAO);
+    glBindVertexArray(0);
+
+    RenderQueue queue;
+    queue.pointInstances = pointInstanceAttributes;
+    beginQueue(queue);
+    DrawPacket walls;
+    walls.key = makeSortKey(passOpaque, 0, 0, 0, 0.0f);
+    walls.kind = drawIndirect;
+    walls.program = program.id;
+    walls.vao = wallVAO;
+    walls.instanceBuffer = wallInstanceBuffer;
+    walls.indirectBuffer = culling.wallCommands;
+    walls.commandCount = culling.chunkCount;
+    submitDraw(queue, walls);
+    DrawPacket cubes = walls;
+    cubes.key = makeSortKey(passOpaque, 0, 1, 0, 0.0f);
+    cubes.vao = cubeVAO;
+    cubes.instanceBuffer = culling.visibleInstances;
+    cubes.indirectBuffer = culling.cubeCommands;
+    cubes.commandCount = culling.groupCount;
+    submitDraw(queue, cubes);
+    flushQueue(queue);
+    glFinish();
+    GLenum error = glGetError();
+
+    printf("%d views, %d chunks, %d enemies, %d bullets\n", views, (int)mesh.chunks.size(), enemyCount, bulletCount);
+    printf("visible per view: %.1f chunks, %.1f cubes\n", (float)visibleChunks / views, (float)visibleInstances / views);
+    printf("wrong chunks: %d, wrong cube sets: %d, indirect draws through the queue: %d of 2, GL error after them: 0x%x\n", wrongChunks, wrongInstances,
+           queue.stats.drawCalls, error);
+    printf("ms per view: gpu %.3f (upload, cull, wait), cpu %.3f\n", gpuTime / views, cpuTime / views);
+
+    deleteGpuCulling(culling);
+    glfwTerminate();
+    return wrongChunks == 0 && wrongInstances == 0 && queue.stats.drawCalls == 2 && error == GL_NO_ERROR ? 0 : 1;
+}
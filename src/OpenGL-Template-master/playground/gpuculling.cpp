@@ -0,0 +1,133 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdio>
+
+#include "gpuculling.hpp"
+
+static const GLuint workGroupSize = 64;             //local_size_x of the compute shader
+
+bool setupGpuCulling(GpuCulling& culling, const std::vector<WallChunk>& chunks, int instanceFloats) {
+    culling = GpuCulling();
+    if (!GLEW_VERSION_4_3) {
+        printf("GL 4.3 is missing, culling stays on the CPU\n");
+        return false;
+    }
+    culling.program = LoadComputeShader("FrustumCull.computeshader");
+    if (culling.program.id == 0) {
+        printf("FrustumCull.computeshader did not build, culling stays on the CPU\n");
+        return false;
+    }
+    culling.modeLocation = GetUniformLocation(culling.program, "mode");
+    culling.objectCountLocation = GetUniformLocation(culling.program, "objectCount");
+    culling.planesLocation = GetUniformLocation(culling.program, "planes");
+    culling.instanceFloatsLocation = GetUniformLocation(culling.program, "instanceFloats");
+    culling.groupEndLocation = GetUniformLocation(culling.program, "groupEnd");
+    culling.groupHalfSizeLocation = GetUniformLocation(culling.program, "groupHalfSize");
+
+    //boxes and commands of the wall chunks never change, only the shader's instanceCount does
+    std::vector<float> boxes;
+    std::vector<DrawCommand> commands;
+    for (const WallChunk& chunk : chunks) {
+        boxes.insert(boxes.end(), { chunk.boxMin[0], chunk.boxMin[1], chunk.boxMin[2], 0.0f, chunk.boxMax[0], chunk.boxMax[1], chunk.boxMax[2], 0.0f });
+        commands.push_back({ (GLuint)chunk.indexCount, 0, (GLuint)chunk.firstIndex, 0, 0 });
+    }
+    culling.chunkCount = (int)chunks.size();
+    culling.instanceFloats = instanceFloats;
+
+    glGenBuffers(1, &culling.chunkBoxes);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.chunkBoxes);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(boxes.size(), 8) * sizeof(float), boxes.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &culling.wallCommands);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.wallCommands);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(commands.size(), 1) * sizeof(DrawCommand), commands.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &culling.sourceInstances);
+    glGenBuffers(1, &culling.visibleInstances);
+    glGenBuffers(1, &culling.cubeCommands);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.cubeCommands);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, maxCullGroups * sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    culling.supported = true;
+    return true;
+}
+
+void runGpuCulling(GpuCulling& culling, const Frustum& frustum, const float* instances, const CullGroup* groups, int groupCount) {
+    int instanceCount = 0;
+    for (int g = 0; g < groupCount; ++g) {
+        instanceCount = std::max(instanceCount, groups[g].first + groups[g].count);
+    }
+
+    //grown, never shrunk, both instance buffers get the same size
+    if (instanceCount > culling.instanceCapacity) {
+        culling.instanceCapacity = std::max(instanceCount, culling.instanceCapacity * 2);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.visibleInstances);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, culling.instanceCapacity * culling.instanceFloats * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.sourceInstances);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, culling.instanceCapacity * culling.instanceFloats * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, instanceCount * culling.instanceFloats * sizeof(float), instances);
+
+    //every group starts empty, the shader counts its visible instances up from its first one
+    DrawCommand commands[maxCullGroups] = {};
+    GLuint groupEnd[maxCullGroups];
+    float halfSizes[maxCullGroups * 3] = {};
+    groupCount = std::min(groupCount, maxCullGroups);
+    for (int g = 0; g < maxCullGroups; ++g) {
+        groupEnd[g] = g < groupCount ? (GLuint)(groups[g].first + groups[g].count) : (GLuint)instanceCount;
+        if (g < groupCount) {
+            commands[g].count = (GLuint)groups[g].indexCount;
+            commands[g].baseInstance = (GLuint)groups[g].first;
+            std::copy(groups[g].halfSize, groups[g].halfSize + 3, halfSizes + g * 3);
+        }
+    }
+    culling.groupCount = groupCount;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.cubeCommands);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(commands), commands);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    float planes[24];
+    for (int i = 0; i < 6; ++i) {
+        planes[i * 4] = frustum.a[i];
+        planes[i * 4 + 1] = frustum.b[i];
+        planes[i * 4 + 2] = frustum.c[i];
+        planes[i * 4 + 3] = frustum.d[i];
+    }
+
+    glUseProgram(culling.program.id);
+    glUniform4fv(culling.planesLocation, 6, planes);
+    glUniform1ui(culling.instanceFloatsLocation, (GLuint)culling.instanceFloats);
+    glUniform1uiv(culling.groupEndLocation, maxCullGroups, groupEnd);
+    glUniform3fv(culling.groupHalfSizeLocation, maxCullGroups, halfSizes);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, culling.chunkBoxes);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, culling.wallCommands);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, culling.sourceInstances);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, culling.visibleInstances);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, culling.cubeCommands);
+
+    if (culling.chunkCount > 0) {
+        glUniform1ui(culling.modeLocation, 0);
+        glUniform1ui(culling.objectCountLocation, (GLuint)culling.chunkCount);
+        glDispatchCompute((culling.chunkCount + workGroupSize - 1) / workGroupSize, 1, 1);
+    }
+    if (instanceCount > 0) {
+        glUniform1ui(culling.modeLocation, 1);
+        glUniform1ui(culling.objectCountLocation, (GLuint)instanceCount);
+        glDispatchCompute((instanceCount + workGroupSize - 1) / workGroupSize, 1, 1);
+    }
+
+    //the draws read the commands and the visible instances the shader wrote
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void deleteGpuCulling(GpuCulling& culling) {
+    if (!culling.supported) {
+        return;
+    }
+    glDeleteProgram(culling.program.id);
+    glDeleteBuffers(1, &culling.chunkBoxes);
+    glDeleteBuffers(1, &culling.wallCommands);
+    glDeleteBuffers(1, &culling.sourceInstances);
+    glDeleteBuffers(1, &culling.visibleInstances);
+    glDeleteBuffers(1, &culling.cubeCommands);
+    culling = GpuCulling();
+}
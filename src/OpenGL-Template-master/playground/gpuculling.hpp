@@ -0,0 +1,49 @@
+#ifndef GPUCULLING_HPP
+#define GPUCULLING_HPP
+
+#include <vector>
+
+#include <common/shader.hpp>
+
+#include "frustum.hpp"
+#include "wallmesh.hpp"
+
+//Optional culling on the GPU for big maps: the wall chunk boxes stay in a buffer, the cube instances are
+//uploaded as they are, and FrustumCull.computeshader writes the draw commands that glMultiDrawElementsIndirect
+//reads, so the CPU neither tests nor sorts anything. Frustum only, no portals and no occlusion. Needs GL 4.3.
+
+const int maxCullGroups = 4;                        //cube draw commands, every group has its own box size
+
+//DrawElementsIndirectCommand from the GL spec
+struct DrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+//instances [first, first + count) of the uploaded ones, culled as boxes of halfSize around their position
+struct CullGroup {
+    int first = 0, count = 0;
+    int indexCount = 36;                            //indices of the mesh every instance is drawn with
+    float halfSize[3] = { 0.5f, 0.5f, 0.5f };
+};
+
+struct GpuCulling {
+    bool supported = false;                         //false without GL 4.3, the CPU path is used then
+    ShaderProgram program;
+    GLint modeLocation, objectCountLocation, planesLocation, instanceFloatsLocation, groupEndLocation, groupHalfSizeLocation;
+    GLuint chunkBoxes, wallCommands;                //static, one command per wall chunk
+    GLuint sourceInstances, visibleInstances, cubeCommands;
+    int chunkCount = 0;
+    int instanceFloats = 0;                         //size of one instance in floats, its first 3 are the position
+    int instanceCapacity = 0;
+    int groupCount = 0;
+};
+
+bool setupGpuCulling(GpuCulling& culling, const std::vector<WallChunk>& chunks, int instanceFloats); //<<< false if GL 4.3 or the compute shader is missing, nothing is created then
+void runGpuCulling(GpuCulling& culling, const Frustum& frustum, const float* instances, const CullGroup* groups, int groupCount); //<<< uploads the instances and fills both command buffers
+void deleteGpuCulling(GpuCulling& culling);
+
+#endif
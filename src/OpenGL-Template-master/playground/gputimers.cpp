@@ -0,0 +1,69 @@
+#include "gputimers.hpp"
+
+#ifdef TANKS_PROFILE
+
+void setupGpuTimers(GpuTimers& timers) {
+    timers.supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (!timers.supported) {
+        return;
+    }
+    for (GpuTimerSet& set : timers.sets) {
+        glGenQueries(maxGpuScopes, set.queries);
+        set.used = 0;
+    }
+    timers.track = profileTrack("GPU");
+}
+
+void beginGpuFrame(GpuTimers& timers) {
+    if (!timers.supported) {
+        return;
+    }
+    //the set about to be reused holds the frame before last, the GPU is usually done with it by now
+    timers.current = 1 - timers.current;
+    timers.open = -1;
+    GpuTimerSet& set = timers.sets[timers.current];
+    for (int i = 0; i < set.used; ++i) {
+        GLint available = 0;
+        glGetQueryObjectiv(set.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            timers.dropped++;
+            continue;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(set.queries[i], GL_QUERY_RESULT, &nanoseconds);
+        recordProfileEvent(set.names[i], timers.track, set.issuedAt[i], (int64_t)nanoseconds, 0);
+    }
+    set.used = 0;
+}
+
+bool beginGpuScope(GpuTimers& timers, const char* name) {
+    GpuTimerSet& set = timers.sets[timers.current];
+    if (!timers.supported || timers.open >= 0 || set.used == maxGpuScopes) {
+        return false;
+    }
+    timers.open = set.used++;
+    set.names[timers.open] = name;
+    set.issuedAt[timers.open] = profileClock();
+    glBeginQuery(GL_TIME_ELAPSED, set.queries[timers.open]);
+    return true;
+}
+
+void endGpuScope(GpuTimers& timers) {
+    if (timers.open < 0) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    timers.open = -1;
+}
+
+void deleteGpuTimers(GpuTimers& timers) {
+    if (!timers.supported) {
+        return;
+    }
+    for (GpuTimerSet& set : timers.sets) {
+        glDeleteQueries(maxGpuScopes, set.queries);
+    }
+    timers.supported = false;
+}
+
+#endif
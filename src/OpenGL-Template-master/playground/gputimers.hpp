@@ -0,0 +1,56 @@
+#ifndef GPUTIMERS_HPP
+#define GPUTIMERS_HPP
+
+#include <GL/glew.h>
+
+#include "profiler.hpp"
+
+//GPU time of parts of a frame from GL_TIME_ELAPSED queries, written into the profiler ring on the "GPU" track.
+//Two sets of queries take turns: a frame's results are read one frame later, and only if the GPU has them,
+//so reading never waits. Timer queries can't nest, a scope opened inside another one is not measured.
+
+const int maxGpuScopes = 8;                         //per frame
+
+struct GpuTimerSet {
+    GLuint queries[maxGpuScopes];
+    const char* names[maxGpuScopes];
+    int64_t issuedAt[maxGpuScopes];                 //profileClock when the scope began, where the trace puts the GPU time
+    int used = 0;
+};
+
+struct GpuTimers {
+    bool supported = false;
+    GpuTimerSet sets[2];
+    int current = 0;                                //set the running frame records into
+    int open = -1;                                  //scope in the current set that has begun and not ended
+    int track = -1;
+    int dropped = 0;                                //results that were not ready after a frame and were thrown away
+};
+
+void setupGpuTimers(GpuTimers& timers); //<<< needs GL 3.3 or ARB_timer_query, unsupported timers do nothing
+void beginGpuFrame(GpuTimers& timers); //<<< reads the set of the frame before last and starts this frame in it
+bool beginGpuScope(GpuTimers& timers, const char* name); //<<< false if it is not measured, then it must not be ended
+void endGpuScope(GpuTimers& timers);
+void deleteGpuTimers(GpuTimers& timers);
+
+//ends the scope at the end of the block
+struct GpuScope {
+    GpuTimers& timers;
+    bool measured;
+    GpuScope(GpuTimers& scopeTimers, const char* name) : timers(scopeTimers), measured(beginGpuScope(timers, name)) {}
+    ~GpuScope() {
+        if (measured) {
+            endGpuScope(timers);
+        }
+    }
+};
+
+#ifdef TANKS_PROFILE
+#define PROFILE_GPU_SCOPE(timers, name) GpuScope PROFILE_CONCAT(gpuScope, __LINE__)(timers, name)
+#define PROFILE_GPU_FRAME(timers) beginGpuFrame(timers)
+#else
+#define PROFILE_GPU_SCOPE(timers, name) ((void)0)
+#define PROFILE_GPU_FRAME(timers) ((void)0)
+#endif
+
+#endif
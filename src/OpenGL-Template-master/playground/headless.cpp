@@ -0,0 +1,230 @@
+//Runs the tanks simulation without a window as fast as possible.
+//The player is steered by a small bot.
+//usage: tanks_headless [ticks]                       runs level 1 matches back to back, reports ticks/second
+//       tanks_headless --batch matches [threads] [seed]  plays independent matches on all cores, reports matches/second
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "simulation.hpp"
+
+//how the bot plays, tuned with --batch on level 1
+const int botLookahead = 40;                        //ticks it looks ahead for enemy bullets
+const float botSafeMiss = 2.0f;                     //a bullet passing farther than this doesn't matter
+const float botCircleMin = 15.0f, botCircleMax = 30.0f; //distance it keeps to the nearest enemy while circling it
+const float botCircleLean = 40.0f;                  //degrees it turns out of the circle to get back into that range
+
+//Aims with the view (cameraYaw) at the nearest enemy it can see and shoots once lined up, so the tank is free to move.
+//For the tank it tries every way to drive and turn for the next ticks against the enemy bullets in flight, as if they
+//flew straight, and takes the one that passes them widest. Of equally safe ones it takes the one that ends up heading
+//around the nearest enemy, so it keeps moving across the enemies' fire instead of into it
+TickInput botInput(const GameState& game) {
+    TickInput input;
+    const cube& player = game.player;
+    const cube* target = nullptr;
+    const cube* nearest = nullptr;
+    float targetDistance = 0.0f, nearestDistance = 0.0f;
+    for (const cube& enemy : game.enemies) {
+        float distance = (enemy.x - player.x) * (enemy.x - player.x) + (enemy.z - player.z) * (enemy.z - player.z);
+        if (!nearest || distance < nearestDistance) {
+            nearest = &enemy;
+            nearestDistance = distance;
+        }
+        if ((!target || distance < targetDistance) && hasLineOfSight(enemy, player, game.wallGrid)) {
+            target = &enemy;
+            targetDistance = distance;
+        }
+    }
+
+    if (target) {
+        float wanted = glm::degrees(atan2(target->x - player.x, -(target->z - player.z)));
+        float turn = std::remainder(wanted - (player.rotation + game.cameraYaw), 360.0f);
+        input.lookLeft = turn < -0.5f;
+        input.lookRight = turn > 0.5f;
+        input.shoot = std::abs(turn) < 2.0f;
+    }
+
+    //across the line to the nearest enemy, leaning out of the circle when it is too close and into it when too far,
+    //on the side that needs less turning
+    float wantedHeading = player.rotation;
+    if (nearest) {
+        float toward = glm::degrees(atan2(nearest->x - player.x, -(nearest->z - player.z)));
+        float distance = std::sqrt(nearestDistance);
+        float lean = distance < botCircleMin ? botCircleLean : (distance > botCircleMax ? -botCircleLean : 0.0f);
+        float left = toward - 90.0f - lean, right = toward + 90.0f + lean;
+        wantedHeading = std::abs(std::remainder(left - player.rotation, 360.0f)) < std::abs(std::remainder(right - player.rotation, 360.0f)) ? left : right;
+    }
+
+    const BulletPool& bullets = game.bullets;
+    float border = game.platformSize / 2.0f - 1.0f;
+    float bestScore = -1e9f;
+    for (int drive = -1; drive <= 1; ++drive) {
+        for (int turn = -1; turn <= 1; ++turn) {
+            float x = player.x, z = player.z, rotation = player.rotation;
+            float closest = botSafeMiss;
+            for (int k = 1; k <= botLookahead; ++k) {
+                rotation += (float)turn;
+                float nextX = x + drive * player.speed * sin(glm::radians(rotation));
+                float nextZ = z - drive * player.speed * cos(glm::radians(rotation));
+                if (std::abs(nextX) < border && std::abs(nextZ) < border && wallCellAt(game.wallGrid, (int)std::floor(nextX + 0.5f), (int)std::floor(nextZ + 0.5f)) < 0) {
+                    x = nextX;
+                    z = nextZ;
+                }
+                for (int i = 0; i < bullets.count; ++i) {
+                    if (bullets.enemy[i]) {
+                        float deltaX = bullets.x[i] + bullets.vx[i] * k - x, deltaZ = bullets.z[i] + bullets.vz[i] * k - z;
+                        closest = std::min(closest, std::sqrt(deltaX * deltaX + deltaZ * deltaZ));
+                    }
+                }
+            }
+            //a tenth of a unit of safety is worth more than any heading, moving is worth a little
+            float score = 10.0f * closest - std::abs(std::remainder(wantedHeading - rotation, 360.0f)) / 180.0f + (drive != 0 ? 0.5f : 0.0f);
+            if (score > bestScore) {
+                bestScore = score;
+                input.forward = drive > 0;
+                input.backward = drive < 0;
+                input.turnLeft = turn < 0;
+                input.turnRight = turn > 0;
+            }
+        }
+    }
+    return input;
+}
+
+//FNV-1a over the bits of all walls and enemies, the same seed has to give the same value on every platform
+uint64_t levelChecksum(const GameState& game) {
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 4; ++i) {
+            hash = (hash ^ ((bits >> (8 * i)) & 0xFF)) * 1099511628211ull;
+        }
+    };
+    for (const wall& w : game.walls) {
+        add(w.x);
+        add(w.z);
+        add(w.h);
+    }
+    for (const cube& enemy : game.enemies) {
+        add(enemy.x);
+        add(enemy.z);
+    }
+    return hash;
+}
+
+//---------------------------------------------------Batch of independent matches---------------------------------------------------//
+const int maxMatchTicks = 3 * 60 * 60;              //a match that takes longer than 3 minutes of game time is a draw
+
+struct MatchResult {
+    unsigned seed;
+    int ticks;
+    int enemiesLeft;
+    bool won, timedOut;
+    int flowRebuilds;                               //of the chase flow field, every time the player changed cells
+};
+
+MatchResult playMatch(int level, unsigned seed) {
+    //every match only touches its own GameState, the level comes from its own seeded Rng
+    GameState game;
+    startGame(game, level, seed, 0.0);
+
+    int ticks = 0;
+    while (!isGameOver(game) && ticks < maxMatchTicks) {
+        simulateTick(game, botInput(game));
+        ticks++;
+    }
+    return { seed, ticks, (int)game.enemies.size(), game.isPlayerAlive && game.enemies.empty(), !isGameOver(game), game.chase.rebuilds };
+}
+
+int runBatch(int matchCount, int threadCount, unsigned firstSeed) {
+    int level = 1;
+    std::vector<MatchResult> results(matchCount);
+    std::atomic<int> nextMatch(0);
+
+    //every thread takes the next unplayed match until none are left, so slow matches don't hold up a whole shard
+    auto worker = [&]() {
+        for (int i = nextMatch++; i < matchCount; i = nextMatch++) {
+            results[i] = playMatch(level, firstSeed + i);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long ticks = 0, rebuilds = 0;
+    int wins = 0, losses = 0, draws = 0;
+    printf("match,seed,result,ticks,enemies_left\n");
+    for (int i = 0; i < matchCount; ++i) {
+        const MatchResult& r = results[i];
+        const char* outcome = r.timedOut ? "draw" : (r.won ? "won" : "lost");
+        printf("%d,%u,%s,%d,%d\n", i, r.seed, outcome, r.ticks, r.enemiesLeft);
+        ticks += r.ticks;
+        rebuilds += r.flowRebuilds;
+        wins += r.won;
+        draws += r.timedOut;
+        losses += !r.won && !r.timedOut;
+    }
+
+    printf("\nmatches:        %d (%d won, %d lost, %d draw)\n", matchCount, wins, losses, draws);
+    printf("threads:        %d\n", threadCount);
+    printf("seconds:        %.3f\n", seconds);
+    printf("matches/second: %.1f\n", matchCount / seconds);
+    printf("ticks/second:   %.0f\n", ticks / seconds);
+    printf("flow rebuilds:  %lld (%.1f per 1000 ticks)\n", rebuilds, rebuilds * 1000.0 / std::max(ticks, 1ll));
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--batch") == 0) {
+        int matchCount = argc > 2 ? std::atoi(argv[2]) : 1000;
+        int threadCount = argc > 3 ? std::atoi(argv[3]) : (int)std::max(1u, std::thread::hardware_concurrency());
+        unsigned firstSeed = argc > 4 ? (unsigned)std::atoi(argv[4]) : 1u;
+        return runBatch(matchCount, threadCount, firstSeed);
+    }
+
+    long long ticks = argc > 1 ? std::atoll(argv[1]) : 100000;
+    int level = 1;
+
+    unsigned seed = 1;
+    GameState game;
+    startGame(game, level, seed, 0.0);
+    printf("level %d seed %u: %d walls, %d enemies, checksum %016llx\n", level, seed, (int)game.walls.size(), (int)game.enemies.size(), (unsigned long long)levelChecksum(game));
+
+    long long matches = 0, wins = 0, rebuilds = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long t = 0; t < ticks; ++t) {
+        simulateTick(game, botInput(game));
+        if (isGameOver(game)) {
+            matches++;
+            wins += game.isPlayerAlive;
+            rebuilds += game.chase.rebuilds;
+            startGame(game, level, ++seed, 0.0);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    rebuilds += game.chase.rebuilds;
+
+    printf("ticks:        %lld\n", ticks);
+    printf("matches:      %lld finished, %lld won\n", matches, wins);
+    printf("seconds:      %.3f\n", seconds);
+    printf("ticks/second: %.0f\n", ticks / seconds);
+    //the chase flow field is rebuilt whenever the bot drives into another cell, most of a tick's cost when it does
+    printf("flow rebuilds: %lld (%.1f per 1000 ticks)\n", rebuilds, rebuilds * 1000.0 / std::max(ticks, 1ll));
+    return 0;
+}
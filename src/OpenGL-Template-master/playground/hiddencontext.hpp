@@ -0,0 +1,31 @@
+#ifndef HIDDENCONTEXT_HPP
+#define HIDDENCONTEXT_HPP
+
+#include <GL/glew.h>
+#include <glfw3.h>
+
+//GL context for the checks and benchmarks that draw without showing a window. Only meant for the bench and check
+//executables, like benchutil.hpp.
+
+//core profile context of at least major.minor in a hidden window of the given size, current and with GLEW loaded.
+//nullptr if the driver has no such context or GLEW fails. glfwInit has to be called before
+inline GLFWwindow* createHiddenContext(int major, int minor, const char* title, int width, int height) {
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    if (!window) {
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        glfwDestroyWindow(window);
+        return nullptr;
+    }
+    glGetError();                                   //glewInit leaves GL_INVALID_ENUM behind on core contexts
+    return window;
+}
+
+#endif
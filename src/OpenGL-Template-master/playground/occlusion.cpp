@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_SSE 1
+#endif
+
+#include "occlusion.hpp"
+#include "profiler.hpp"
+
+static const float nearW = 0.1f;                    //same as the camera's near plane
+
+//a vertex after the view projection, before the divide by w
+struct ClipVertex {
+    float x, y, w;
+};
+
+//in screen pixels, y up, with 1 / w for the depth
+struct ScreenVertex {
+    float x, y, inverseW;
+};
+
+static ClipVertex transform(const float* m, const float* p) {
+    return { m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+             m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+             m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15] };
+}
+
+static ScreenVertex toScreen(const ClipVertex& v) {
+    float inverseW = 1.0f / v.w;
+    return { (v.x * inverseW * 0.5f + 0.5f) * occlusionWidth, (v.y * inverseW * 0.5f + 0.5f) * occlusionHeight, inverseW };
+}
+
+void clearOcclusion(OcclusionBuffer& buffer, const float* viewProjection) {
+    std::copy(viewProjection, viewProjection + 16, buffer.viewProjection);
+    buffer.depth.assign(occlusionWidth * occlusionHeight, 0.0f);
+    buffer.tileFarthest.assign((occlusionWidth / occlusionTile) * (occlusionHeight / occlusionTile), 0.0f);
+    buffer.trianglesDrawn = 0;
+}
+
+//Edge functions are tested against the pixel corner that is furthest outside, so a pixel only counts
+//when the triangle covers all of it, and its depth is the farthest the triangle gets inside the pixel.
+//That way a box is never hidden by a pixel the occluder only partly covers.
+static void rasterizeTriangle(OcclusionBuffer& buffer, const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (area <= 0.0f) {
+        return;                                     //back facing, the front faces of the same wall hide more
+    }
+
+    //E(x, y) = a x + b y + c, positive inside, minus half a pixel in the worst direction
+    const ScreenVertex* v[3] = { &v0, &v1, &v2 };
+    float a[3], b[3], c[3];
+    for (int k = 0; k < 3; ++k) {
+        const ScreenVertex& from = *v[k];
+        const ScreenVertex& to = *v[(k + 1) % 3];
+        a[k] = -(to.y - from.y);
+        b[k] = to.x - from.x;
+        c[k] = -(a[k] * from.x + b[k] * from.y) - 0.5f * (std::abs(a[k]) + std::abs(b[k]));
+    }
+    float depthX = ((v1.inverseW - v0.inverseW) * (v2.y - v0.y) - (v2.inverseW - v0.inverseW) * (v1.y - v0.y)) / area;
+    float depthY = ((v2.inverseW - v0.inverseW) * (v1.x - v0.x) - (v1.inverseW - v0.inverseW) * (v2.x - v0.x)) / area;
+    float depthC = v0.inverseW - depthX * v0.x - depthY * v0.y - 0.5f * (std::abs(depthX) + std::abs(depthY));
+
+    int minX = std::max(0, (int)std::floor(std::min({ v0.x, v1.x, v2.x })));
+    int maxX = std::min(occlusionWidth - 1, (int)std::ceil(std::max({ v0.x, v1.x, v2.x })));
+    int minY = std::max(0, (int)std::floor(std::min({ v0.y, v1.y, v2.y })));
+    int maxY = std::min(occlusionHeight - 1, (int)std::ceil(std::max({ v0.y, v1.y, v2.y })));
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+    minX &= ~3;                                     //4 pixels per step, the width is a multiple of 4
+
+    for (int y = minY; y <= maxY; ++y) {
+        float centerY = y + 0.5f;
+        float* row = &buffer.depth[y * occlusionWidth];
+        int x = minX;
+#ifdef OCCLUSION_SSE
+        const __m128 laneOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        __m128 edgeA[3], edgeRow[3];
+        for (int k = 0; k < 3; ++k) {
+            edgeA[k] = _mm_set1_ps(a[k]);
+            edgeRow[k] = _mm_set1_ps(b[k] * centerY + c[k]);
+        }
+        __m128 depthA = _mm_set1_ps(depthX);
+        __m128 depthRow = _mm_set1_ps(depthY * centerY + depthC);
+        for (; x <= maxX; x += 4) {
+            __m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+            __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], centerX), edgeRow[0]), _mm_setzero_ps());
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], centerX), edgeRow[1]), _mm_setzero_ps()));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], centerX), edgeRow[2]), _mm_setzero_ps()));
+            //outside pixels become 0, which never beats what is already in the buffer
+            __m128 depth = _mm_and_ps(inside, _mm_add_ps(_mm_mul_ps(depthA, centerX), depthRow));
+            _mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x), depth));
+        }
+#endif
+        for (; x <= maxX; ++x) {
+            float centerX = x + 0.5f;
+            bool inside = true;
+            for (int k = 0; k < 3; ++k) {
+                inside = inside && a[k] * centerX + b[k] * centerY + c[k] >= 0.0f;
+            }
+            if (inside) {
+                row[x] = std::max(row[x], depthX * centerX + depthY * centerY + depthC);
+            }
+        }
+    }
+    buffer.trianglesDrawn++;
+}
+
+void drawOccluders(OcclusionBuffer& buffer, const float* positions, const unsigned int* indices, int indexCount) {
+    const float* m = buffer.viewProjection;
+    for (int i = 0; i + 2 < indexCount; i += 3) {
+        ClipVertex corners[3];
+        for (int k = 0; k < 3; ++k) {
+            corners[k] = transform(m, positions + indices[i + k] * 3);
+        }
+
+        //cut away what is in front of the near plane, a triangle becomes at most a quad
+        ClipVertex clipped[4];
+        int count = 0;
+        for (int k = 0; k < 3; ++k) {
+            const ClipVertex& from = corners[k];
+            const ClipVertex& to = corners[(k + 1) % 3];
+            bool fromInside = from.w >= nearW;
+            bool toInside = to.w >= nearW;
+            if (fromInside) {
+                clipped[count++] = from;
+            }
+            if (fromInside != toInside) {
+                float t = (nearW - from.w) / (to.w - from.w);
+                clipped[count++] = { from.x + t * (to.x - from.x), from.y + t * (to.y - from.y), nearW };
+            }
+        }
+        if (count < 3) {
+            continue;
+        }
+
+        ScreenVertex screen[4];
+        for (int k = 0; k < count; ++k) {
+            screen[k] = toScreen(clipped[k]);
+        }
+        for (int k = 1; k + 1 < count; ++k) {
+            rasterizeTriangle(buffer, screen[0], screen[k], screen[k + 1]);
+        }
+    }
+}
+
+void finishOcclusion(OcclusionBuffer& buffer) {
+    int tilesX = occlusionWidth / occlusionTile;
+    for (int ty = 0; ty < occlusionHeight / occlusionTile; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            float farthest = buffer.depth[(ty * occlusionTile) * occlusionWidth + tx * occlusionTile];
+            for (int y = ty * occlusionTile; y < (ty + 1) * occlusionTile; ++y) {
+                for (int x = tx * occlusionTile; x < (tx + 1) * occlusionTile; ++x) {
+                    farthest = std::min(farthest, buffer.depth[y * occlusionWidth + x]);
+                }
+            }
+            buffer.tileFarthest[ty * tilesX + tx] = farthest;
+        }
+    }
+}
+
+bool boxOccluded(const OcclusionBuffer& buffer, const float boxMin[3], const float boxMax[3]) {
+    //screen rectangle around the 8 corners and the depth of the nearest one
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = 0.0f;
+    for (int i = 0; i < 8; ++i) {
+        const float corner[3] = { i & 1 ? boxMax[0] : boxMin[0], i & 2 ? boxMax[1] : boxMin[1], i & 4 ? boxMax[2] : boxMin[2] };
+        ClipVertex clip = transform(buffer.viewProjection, corner);
+        if (clip.w < nearW) {
+            return false;                           //reaches up to the camera
+        }
+        ScreenVertex screen = toScreen(clip);
+        minX = std::min(minX, screen.x);
+        maxX = std::max(maxX, screen.x);
+        minY = std::min(minY, screen.y);
+        maxY = std::max(maxY, screen.y);
+        nearest = std::max(nearest, screen.inverseW);
+    }
+
+    int x0 = std::max(0, (int)std::floor(minX));
+    int x1 = std::min(occlusionWidth - 1, (int)std::ceil(maxX) - 1);
+    int y0 = std::max(0, (int)std::floor(minY));
+    int y1 = std::min(occlusionHeight - 1, (int)std::ceil(maxY) - 1);
+    if (x0 > x1 || y0 > y1) {
+        return false;                               //off screen, that is for the frustum test to decide
+    }
+
+    int tilesX = occlusionWidth / occlusionTile;
+    for (int ty = y0 / occlusionTile; ty <= y1 / occlusionTile; ++ty) {
+        for (int tx = x0 / occlusionTile; tx <= x1 / occlusionTile; ++tx) {
+            if (buffer.tileFarthest[ty * tilesX + tx] > nearest) {
+                continue;                           //every pixel of the tile is in front of the box
+            }
+            int yEnd = std::min(y1, ty * occlusionTile + occlusionTile - 1);
+            int xEnd = std::min(x1, tx * occlusionTile + occlusionTile - 1);
+            for (int y = std::max(y0, ty * occlusionTile); y <= yEnd; ++y) {
+                for (int x = std::max(x0, tx * occlusionTile); x <= xEnd; ++x) {
+                    if (buffer.depth[y * occlusionWidth + x] <= nearest) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void runOcclusionJob(OcclusionJob& job, OcclusionBuffer& buffer) {
+    PROFILE_SCOPE("occlusionJob");
+    auto start = std::chrono::steady_clock::now();
+    const WallMesh& mesh = *job.occluders;
+    clearOcclusion(buffer, job.viewProjection);
+
+    //the nearest chunks hide the most, they are drawn until the budget is used up
+    std::vector<std::pair<float, int>> byDistance;
+    for (int chunk : job.chunks) {
+        const WallChunk& c = mesh.chunks[chunk];
+        float dx = (c.boxMin[0] + c.boxMax[0]) * 0.5f - job.eye[0];
+        float dz = (c.boxMin[2] + c.boxMax[2]) * 0.5f - job.eye[2];
+        byDistance.push_back({ dx * dx + dz * dz, chunk });
+    }
+    std::sort(byDistance.begin(), byDistance.end());
+    int triangles = 0;
+    for (const auto& entry : byDistance) {
+        const WallChunk& c = mesh.chunks[entry.second];
+        if (triangles + c.indexCount / 3 > job.triangleBudget) {
+            break;
+        }
+        drawOccluders(buffer, mesh.positions.data(), mesh.indices.data() + c.firstIndex, c.indexCount);
+        triangles += c.indexCount / 3;
+    }
+    finishOcclusion(buffer);
+
+    job.stats = OcclusionStats();
+    job.stats.trianglesDrawn = buffer.trianglesDrawn;
+    job.chunkVisible.resize(job.chunks.size());
+    for (size_t i = 0; i < job.chunks.size(); ++i) {
+        const WallChunk& c = mesh.chunks[job.chunks[i]];
+        job.chunkVisible[i] = !boxOccluded(buffer, c.boxMin, c.boxMax);
+        job.stats.chunksOccluded += !job.chunkVisible[i];
+    }
+    int boxCount = (int)job.boxes.size() / 6;
+    job.boxVisible.resize(boxCount);
+    for (int i = 0; i < boxCount; ++i) {
+        job.boxVisible[i] = !boxOccluded(buffer, &job.boxes[i * 6], &job.boxes[i * 6 + 3]);
+        job.stats.boxesOccluded += !job.boxVisible[i];
+    }
+    job.stats.chunksTested = (int)job.chunks.size();
+    job.stats.boxesTested = boxCount;
+    job.stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//---------------------------------------------------Worker thread---------------------------------------------------//
+void startOcclusionWorker(OcclusionWorker& worker) {
+    worker.quit = false;
+    worker.job = nullptr;
+    worker.thread = std::thread([&worker]() {
+        PROFILE_THREAD("occlusion");
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        while (true) {
+            worker.wake.wait(lock, [&worker]() { return worker.job || worker.quit; });
+            if (worker.quit) {
+                return;
+            }
+            //the job belongs to this thread until it is done, the lock is not needed for it
+            lock.unlock();
+            runOcclusionJob(*worker.job, worker.buffer);
+            lock.lock();
+            worker.job = nullptr;
+            worker.finished.notify_all();
+        }
+    });
+}
+
+void submitOcclusionJob(OcclusionWorker& worker, OcclusionJob& job) {
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.job = &job;
+    }
+    worker.wake.notify_one();
+}
+
+void waitOcclusionJob(OcclusionWorker& worker) {
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    worker.finished.wait(lock, [&worker]() { return worker.job == nullptr; });
+}
+
+void stopOcclusionWorker(OcclusionWorker& worker) {
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.quit = true;
+    }
+    worker.wake.notify_one();
+    if (worker.thread.joinable()) {
+        worker.thread.join();
+    }
+}
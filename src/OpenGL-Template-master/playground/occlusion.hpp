@@ -0,0 +1,67 @@
+#ifndef OCCLUSION_HPP
+#define OCCLUSION_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "wallmesh.hpp"
+
+//Software occlusion culling on the CPU: the nearest walls are rasterized into a small depth buffer,
+//then the bounding boxes of everything else are tested against it. No GL, so it also runs headless.
+
+const int occlusionWidth = 256;                     //16:9 like the window, a pixel covers 10x10 screen pixels
+const int occlusionHeight = 144;
+const int occlusionTile = 8;                        //tiles of 8x8 pixels keep the farthest depth they hold
+
+struct OcclusionBuffer {
+    float viewProjection[16];                       //column major like glm::value_ptr
+    std::vector<float> depth;                       //1 / w of the nearest occluder that covers the whole pixel, 0 where there is none
+    std::vector<float> tileFarthest;                //smallest depth in every tile
+    int trianglesDrawn = 0;
+};
+
+void clearOcclusion(OcclusionBuffer& buffer, const float* viewProjection); //<<< empty buffer for a new camera
+void drawOccluders(OcclusionBuffer& buffer, const float* positions, const unsigned int* indices, int indexCount); //<<< rasterizes front facing triangles, only pixels they cover completely
+void finishOcclusion(OcclusionBuffer& buffer); //<<< updates the tiles, call before boxOccluded
+bool boxOccluded(const OcclusionBuffer& buffer, const float boxMin[3], const float boxMax[3]); //<<< true only if every pixel the box could touch has an occluder in front of all of it
+
+//what the last job kept and dropped
+struct OcclusionStats {
+    int trianglesDrawn = 0;
+    int chunksTested = 0, chunksOccluded = 0;
+    int boxesTested = 0, boxesOccluded = 0;
+    double milliseconds = 0.0;
+};
+
+//one frame of work: the wall chunks and boxes that passed frustum and portals, tested against the nearest walls
+struct OcclusionJob {
+    float viewProjection[16];
+    float eye[3];
+    const WallMesh* occluders = nullptr;            //must not change while the job runs
+    int triangleBudget = 4000;                      //triangles rasterized per frame, the nearest chunks go first
+    std::vector<int> chunks;                        //indices into occluders->chunks
+    std::vector<float> boxes;                       //6 floats per box: min x, y, z, max x, y, z
+    std::vector<char> chunkVisible, boxVisible;     //filled by the job, one per chunk and per box
+    OcclusionStats stats;
+};
+
+void runOcclusionJob(OcclusionJob& job, OcclusionBuffer& buffer); //<<< runs the whole job on the calling thread
+
+//a thread that runs one job at a time, so the occlusion test overlaps with the simulation
+struct OcclusionWorker {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    OcclusionJob* job = nullptr;                    //submitted and not finished yet
+    bool quit = false;
+    OcclusionBuffer buffer;
+};
+
+void startOcclusionWorker(OcclusionWorker& worker);
+void submitOcclusionJob(OcclusionWorker& worker, OcclusionJob& job); //<<< returns at once, the job must not be touched until waitOcclusionJob
+void waitOcclusionJob(OcclusionWorker& worker); //<<< blocks until the submitted job is done
+void stopOcclusionWorker(OcclusionWorker& worker);
+
+#endif
@@ -0,0 +1,196 @@
+//Benchmark for the software occlusion culling: random first person views on level 1 and on a dense field
+//of random walls that has no rooms. Every wall box and enemy sized box the frustum keeps is tested against the
+//occlusion buffer and against rays marched through the wall columns.
+//"missed" are boxes the buffer hid although a ray reaches them, it has to stay 0.
+//The last lines run the job on the worker thread while the main thread simulates level 1.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "benchutil.hpp"
+#include "frustum.hpp"
+#include "occlusion.hpp"
+#include "simulation.hpp"
+
+struct Counts {
+    int frustum = 0, kept = 0, visible = 0, missed = 0;
+};
+
+static void addBox(OcclusionJob& job, const float boxMin[3], const float boxMax[3]) {
+    job.boxes.insert(job.boxes.end(), boxMin, boxMin + 3);
+    job.boxes.insert(job.boxes.end(), boxMax, boxMax + 3);
+}
+
+//random views over one map, prints one row for enemy boxes and one for walls
+static void runViews(const char* name, const std::vector<wall>& walls, float half, int views) {
+    WallGrid grid = buildWallGrid(walls);
+    WallMesh mesh = bakeWallMesh(walls);
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), 2560.0f / 1440.0f, 0.1f, 100.0f);
+    OcclusionBuffer buffer;
+    Counts enemies, wallCounts;
+    long long chunksTested = 0, chunksOccluded = 0, triangles = 0;
+    double milliseconds = 0.0;
+
+    std::srand(5);
+    for (int v = 0; v < views; ++v) {
+        glm::vec3 eye;
+        do {
+            eye = glm::vec3(randomRange(-half, half), 2.0f, randomRange(-half, half));
+        } while (wallAtPoint(grid, walls, eye.x, eye.z) >= 0);
+        float yaw = randomRange(0.0f, 6.283f);
+        glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(sin(yaw), 0.0f, -cos(yaw)), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 viewProjection = projection * view;
+        Frustum frustum = extractFrustum(glm::value_ptr(viewProjection));
+
+        OcclusionJob job;
+        std::copy(glm::value_ptr(viewProjection), glm::value_ptr(viewProjection) + 16, job.viewProjection);
+        job.eye[0] = eye.x;
+        job.eye[1] = eye.y;
+        job.eye[2] = eye.z;
+        job.occluders = &mesh;
+        for (int c = 0; c < (int)mesh.chunks.size(); ++c) {
+            if (boxVisible(frustum, mesh.chunks[c].boxMin, mesh.chunks[c].boxMax)) {
+                job.chunks.push_back(c);
+            }
+        }
+
+        //enemy sized boxes first, then every wall in the frustum
+        std::vector<glm::vec3> enemyCenters;
+        for (int k = 0; k < 100; ++k) {
+            glm::vec3 center(randomRange(-half, half), 0.5f, randomRange(-half, half));
+            const float boxMin[3] = { center.x - 0.5f, 0.0f, center.z - 0.5f };
+            const float boxMax[3] = { center.x + 0.5f, 1.0f, center.z + 0.5f };
+            if (wallAtPoint(grid, walls, center.x, center.z) >= 0 || !boxVisible(frustum, boxMin, boxMax)) continue;
+            enemyCenters.push_back(center);
+            addBox(job, boxMin, boxMax);
+        }
+        std::vector<int> wallIndices;
+        for (int i = 0; i < (int)walls.size(); ++i) {
+            const wall& w = walls[i];
+            const float boxMin[3] = { w.x - 0.5f, 0.0f, w.z - 0.5f };
+            const float boxMax[3] = { w.x + 0.5f, w.h, w.z + 0.5f };
+            if (!boxVisible(frustum, boxMin, boxMax)) continue;
+            wallIndices.push_back(i);
+            addBox(job, boxMin, boxMax);
+        }
+
+        runOcclusionJob(job, buffer);
+        milliseconds += job.stats.milliseconds;
+        chunksTested += job.stats.chunksTested;
+        chunksOccluded += job.stats.chunksOccluded;
+        triangles += job.stats.trianglesDrawn;
+
+        int box = 0;
+        for (const glm::vec3& center : enemyCenters) {
+            bool visible = false;
+            for (int s = 0; s < 40 && !visible; ++s) {
+                glm::vec3 p(center.x + randomRange(-0.5f, 0.5f), randomRange(0.0f, 1.0f), center.z + randomRange(-0.5f, 0.5f));
+                visible = pointInFrustum(frustum, p) && !rayBlocked(walls, grid, eye, p, -1);
+            }
+            bool kept = job.boxVisible[box++] != 0;
+            enemies.frustum++;
+            enemies.kept += kept;
+            enemies.visible += visible;
+            enemies.missed += visible && !kept;
+        }
+        //rays aim at points just outside the faces of the wall
+        for (int i : wallIndices) {
+            const wall& w = walls[i];
+            bool visible = false;
+            for (int s = 0; s < 40 && !visible; ++s) {
+                float along = randomRange(-0.5f, 0.5f), y = randomRange(0.0f, w.h);
+                glm::vec3 faces[5] = { { w.x + 0.501f, y, w.z + along }, { w.x - 0.501f, y, w.z + along },
+                                       { w.x + along, y, w.z + 0.501f }, { w.x + along, y, w.z - 0.501f },
+                                       { w.x + along, w.h + 0.001f, w.z + randomRange(-0.5f, 0.5f) } };
+                glm::vec3 p = faces[std::rand() % 5];
+                visible = pointInFrustum(frustum, p) && !rayBlocked(walls, grid, eye, p, i);
+            }
+            bool kept = job.boxVisible[box++] != 0;
+            wallCounts.frustum++;
+            wallCounts.kept += kept;
+            wallCounts.visible += visible;
+            wallCounts.missed += visible && !kept;
+        }
+    }
+    printf("%-10s %-6s %8d %8d %8d %8d %10.3f\n", name, "enemy", enemies.frustum, enemies.kept, enemies.visible, enemies.missed, milliseconds / views);
+    printf("%-10s %-6s %8d %8d %8d %8d\n", name, "wall", wallCounts.frustum, wallCounts.kept, wallCounts.visible, wallCounts.missed);
+    printf("%-10s %-6s %8lld %8lld %8s %8s   %lld triangles/view\n", name, "chunk", chunksTested, chunksTested - chunksOccluded, "", "", triangles / views);
+}
+
+int main() {
+    GameState game;
+    startGame(game, 1, 1, 0.0);
+
+    //no rooms, walls of random height on about a quarter of the cells, never exactly at eye height
+    //where a top is only seen edge on and the rays would still graze it
+    std::srand(4);
+    std::vector<wall> dense;
+    for (int z = -40; z <= 40; ++z) {
+        for (int x = -40; x <= 40; ++x) {
+            if (std::rand() % 4 == 0 && (std::abs(x) > 2 || std::abs(z) > 2)) {
+                dense.push_back({ (float)x, (float)z, 1.0f + 0.9f * (std::rand() % 5) });
+            }
+        }
+    }
+
+    const int views = 200;
+    printf("%d views per map, %d x %d buffer\n", views, occlusionWidth, occlusionHeight);
+    printf("%-10s %-6s %8s %8s %8s %8s %10s\n", "map", "boxes", "frustum", "kept", "visible", "missed", "ms/view");
+    runViews("level 1", game.walls, 59.0f, views);
+    runViews("dense", dense, 40.0f, views);
+
+    //the job of a level 1 view on the worker against simulating the 1-2 ticks of a frame on the main thread
+    WallMesh mesh = bakeWallMesh(game.walls);
+    glm::vec3 eye(0.0f, 2.0f, -50.0f);
+    glm::mat4 viewProjection = glm::perspective(glm::radians(70.0f), 2560.0f / 1440.0f, 0.1f, 100.0f) *
+                               glm::lookAt(eye, eye + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    OcclusionJob job;
+    std::copy(glm::value_ptr(viewProjection), glm::value_ptr(viewProjection) + 16, job.viewProjection);
+    job.eye[0] = eye.x;
+    job.eye[1] = eye.y;
+    job.eye[2] = eye.z;
+    job.occluders = &mesh;
+    for (int c = 0; c < (int)mesh.chunks.size(); ++c) {
+        job.chunks.push_back(c);
+    }
+    for (const wall& w : game.walls) {
+        const float boxMin[3] = { w.x - 0.5f, 0.0f, w.z - 0.5f };
+        const float boxMax[3] = { w.x + 0.5f, w.h, w.z + 0.5f };
+        addBox(job, boxMin, boxMax);
+    }
+
+    const int frames = 500;
+    OcclusionBuffer buffer;
+    double jobTime = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        runOcclusionJob(job, buffer);
+        jobTime += job.stats.milliseconds;
+        simulateTick(game, TickInput());
+        simulateTick(game, TickInput());
+    }
+    double serial = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    jobTime /= frames;
+
+    OcclusionWorker worker;
+    startOcclusionWorker(worker);
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        submitOcclusionJob(worker, job);
+        simulateTick(game, TickInput());
+        simulateTick(game, TickInput());
+        waitOcclusionJob(worker);
+    }
+    double overlapped = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    stopOcclusionWorker(worker);
+
+    printf("\nlevel 1 frame: job %.3f ms, 2 ticks %.3f ms\n", jobTime, serial - jobTime);
+    printf("one after the other %.3f ms, job on the worker %.3f ms\n", serial, overlapped);
+    return 0;
+}
@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "overlay.hpp"
+
+#ifdef TANKS_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#endif
+
+//font8x8_basic by Daniel Hepper (public domain), characters 32 to 126, a row per byte from the top, bit 0 is the left pixel
+static const unsigned char builtinFont[lastAtlasChar - firstAtlasChar + 1][8] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  //' '
+    { 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 },  //!
+    { 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  //"
+    { 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 },  //#
+    { 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 },  //$
+    { 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 },  //%
+    { 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 },  //&
+    { 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },  //quote
+    { 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 },  //(
+    { 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 },  //)
+    { 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 },  //*
+    { 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 },  //+
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 },  //,
+    { 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 },  //-
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 },  //.
+    { 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 },  ///
+    { 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 },  //0
+    { 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 },  //1
+    { 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 },  //2
+    { 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 },  //3
+    { 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 },  //4
+    { 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 },  //5
+    { 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 },  //6
+    { 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 },  //7
+    { 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 },  //8
+    { 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 },  //9
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 },  //:
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 },  //;
+    { 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 },  //<
+    { 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 },  //=
+    { 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 },  //>
+    { 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 },  //?
+    { 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 },  //@
+    { 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 },  //A
+    { 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 },  //B
+    { 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 },  //C
+    { 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 },  //D
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 },  //E
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 },  //F
+    { 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 },  //G
+    { 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 },  //H
+    { 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  //I
+    { 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 },  //J
+    { 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 },  //K
+    { 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 },  //L
+    { 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 },  //M
+    { 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 },  //N
+    { 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 },  //O
+    { 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 },  //P
+    { 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 },  //Q
+    { 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 },  //R
+    { 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 },  //S
+    { 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  //T
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 },  //U
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },  //V
+    { 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 },  //W
+    { 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 },  //X
+    { 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 },  //Y
+    { 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 },  //Z
+    { 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 },  //[
+    { 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 },  //backslash
+    { 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 },  //]
+    { 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 },  //^
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF },  //_
+    { 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },  //`
+    { 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 },  //a
+    { 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 },  //b
+    { 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 },  //c
+    { 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 },  //d
+    { 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 },  //e
+    { 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 },  //f
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F },  //g
+    { 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 },  //h
+    { 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  //i
+    { 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E },  //j
+    { 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 },  //k
+    { 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  //l
+    { 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 },  //m
+    { 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 },  //n
+    { 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 },  //o
+    { 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F },  //p
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 },  //q
+    { 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 },  //r
+    { 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 },  //s
+    { 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 },  //t
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 },  //u
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },  //v
+    { 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 },  //w
+    { 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 },  //x
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F },  //y
+    { 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 },  //z
+    { 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 },  //{
+    { 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 },  //|
+    { 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 },  //}
+    { 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  //~
+};
+
+static const int glyphCount = lastAtlasChar - firstAtlasChar + 1;
+
+static double overlayClock() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t overlayColor(float r, float g, float b, float a) {
+    auto byte = [](float value) { return (uint32_t)std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f); };
+    unsigned char bytes[4] = { (unsigned char)byte(r), (unsigned char)byte(g), (unsigned char)byte(b), (unsigned char)byte(a) };
+    uint32_t color;
+    std::memcpy(&color, bytes, sizeof(color));
+    return color;
+}
+
+//16 glyphs a row in 8x8 cells, the one cell left over is the white one
+static void buildBuiltinAtlas(GlyphAtlas& atlas, std::vector<unsigned char>& pixels, int pixelHeight) {
+    atlas.width = 128;
+    atlas.height = 48;
+    pixels.assign(atlas.width * atlas.height, 0);
+    for (int cell = 0; cell < 96; ++cell) {
+        int cellX = cell % 16 * 8, cellY = cell / 16 * 8;
+        for (int row = 0; row < 8; ++row) {
+            for (int bit = 0; bit < 8; ++bit) {
+                bool set = cell == glyphCount || (builtinFont[cell][row] >> bit & 1);
+                pixels[(cellY + row) * atlas.width + cellX + bit] = set ? 255 : 0;
+            }
+        }
+        if (cell == glyphCount) {
+            atlas.whiteU = (cellX + 4.0f) / atlas.width;
+            atlas.whiteV = (cellY + 4.0f) / atlas.height;
+            continue;
+        }
+        Glyph& glyph = atlas.glyphs[cell];
+        glyph.u0 = (float)cellX / atlas.width;
+        glyph.v0 = (float)cellY / atlas.height;
+        glyph.u1 = (cellX + 8.0f) / atlas.width;
+        glyph.v1 = (cellY + 8.0f) / atlas.height;
+        glyph.width = glyph.height = 8;
+        glyph.left = 0;
+        glyph.top = 7;                              //the last row is below the baseline
+        glyph.advance = 8;
+    }
+    atlas.ascent = 7;
+    atlas.lineHeight = 10;
+    atlas.scale = std::max(1, (pixelHeight + 4) / 8);
+    atlas.fromFont = false;
+}
+
+#ifdef TANKS_FREETYPE
+//every glyph rendered as an antialiased bitmap and packed in rows into an atlas 512 wide, false if the font does not load
+static bool buildFontAtlas(GlyphAtlas& atlas, std::vector<unsigned char>& pixels, const char* path, int pixelHeight) {
+    FT_Library library;
+    if (FT_Init_FreeType(&library)) {
+        return false;
+    }
+    FT_Face face;
+    if (FT_New_Face(library, path, 0, &face)) {
+        FT_Done_FreeType(library);
+        return false;
+    }
+    FT_Set_Pixel_Sizes(face, 0, pixelHeight);
+
+    std::vector<std::vector<unsigned char>> bitmaps(glyphCount);
+    for (int i = 0; i < glyphCount; ++i) {
+        Glyph& glyph = atlas.glyphs[i];
+        glyph = Glyph();
+        if (FT_Load_Char(face, firstAtlasChar + i, FT_LOAD_RENDER)) {
+            continue;
+        }
+        const FT_GlyphSlot slot = face->glyph;
+        glyph.width = (int)slot->bitmap.width;
+        glyph.height = (int)slot->bitmap.rows;
+        glyph.left = slot->bitmap_left;
+        glyph.top = slot->bitmap_top;
+        glyph.advance = (int)(slot->advance.x >> 6);
+        bitmaps[i].resize(glyph.width * glyph.height);
+        for (int row = 0; row < glyph.height; ++row) {
+            std::memcpy(&bitmaps[i][row * glyph.width], slot->bitmap.buffer + row * slot->bitmap.pitch, glyph.width);
+        }
+    }
+    atlas.ascent = (int)(face->size->metrics.ascender >> 6);
+    atlas.lineHeight = (int)(face->size->metrics.height >> 6);
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+
+    //a 2x2 white block in the corner, then the glyphs with a texel of space around each
+    atlas.width = 512;
+    int x = 4, y = 1, rowHeight = 3;
+    std::vector<int> placedX(glyphCount), placedY(glyphCount);
+    for (int i = 0; i < glyphCount; ++i) {
+        const Glyph& glyph = atlas.glyphs[i];
+        if (x + glyph.width + 1 > atlas.width) {
+            x = 1;
+            y += rowHeight + 1;
+            rowHeight = 0;
+        }
+        placedX[i] = x;
+        placedY[i] = y;
+        x += glyph.width + 1;
+        rowHeight = std::max(rowHeight, glyph.height);
+    }
+    atlas.height = (y + rowHeight + 1 + 3) & ~3;
+    pixels.assign(atlas.width * atlas.height, 0);
+    for (int row = 1; row < 3; ++row) {
+        pixels[row * atlas.width + 1] = pixels[row * atlas.width + 2] = 255;
+    }
+    atlas.whiteU = 2.0f / atlas.width;
+    atlas.whiteV = 2.0f / atlas.height;
+    for (int i = 0; i < glyphCount; ++i) {
+        Glyph& glyph = atlas.glyphs[i];
+        for (int row = 0; row < glyph.height; ++row) {
+            std::memcpy(&pixels[(placedY[i] + row) * atlas.width + placedX[i]], &bitmaps[i][row * glyph.width], glyph.width);
+        }
+        glyph.u0 = (float)placedX[i] / atlas.width;
+        glyph.v0 = (float)placedY[i] / atlas.height;
+        glyph.u1 = (float)(placedX[i] + glyph.width) / atlas.width;
+        glyph.v1 = (float)(placedY[i] + glyph.height) / atlas.height;
+    }
+    atlas.scale = 1;
+    atlas.fromFont = true;
+    return true;
+}
+#endif
+
+bool setupOverlay(Overlay& overlay, const std::vector<const char*>& fontPaths, int pixelHeight, int screenWidth, int screenHeight) {
+    overlay = Overlay();
+    overlay.screenWidth = (float)screenWidth;
+    overlay.screenHeight = (float)screenHeight;
+    overlay.program = LoadShaders("OverlayVertexShader.vertexshader", "OverlayFragmentShader.fragmentshader");
+    if (overlay.program.id == 0) {
+        printf("The overlay shaders did not build, no overlay\n");
+        return false;
+    }
+
+    GlyphAtlas& atlas = overlay.atlas;
+    std::vector<unsigned char> pixels;
+    const char* loaded = nullptr;
+#ifdef TANKS_FREETYPE
+    for (const char* path : fontPaths) {
+        if (buildFontAtlas(atlas, pixels, path, pixelHeight)) {
+            loaded = path;
+            break;
+        }
+    }
+#else
+    (void)fontPaths;                                //without FreeType the 8x8 font is all there is
+#endif
+    if (!loaded) {
+        buildBuiltinAtlas(atlas, pixels, pixelHeight);
+    }
+    printf("Overlay font: %s, %dx%d atlas\n", loaded ? loaded : "built in 8x8", atlas.width, atlas.height);
+
+    glGenTextures(1, &atlas.texture);
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas.width, atlas.height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    //the quads sit on whole pixels and the atlas is only scaled by whole numbers, nearest keeps the glyphs sharp
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    overlay.capacity = 6 * 1024;
+    glGenVertexArrays(1, &overlay.vao);
+    glGenBuffers(1, &overlay.buffer);
+    glBindVertexArray(overlay.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, overlay.buffer);
+    glBufferData(GL_ARRAY_BUFFER, overlay.capacity * sizeof(OverlayVertex), nullptr, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (void*)offsetof(OverlayVertex, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (void*)offsetof(OverlayVertex, u));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(OverlayVertex), (void*)offsetof(OverlayVertex, color));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    overlay.vertices.reserve(overlay.capacity);
+    return true;
+}
+
+void beginOverlay(Overlay& overlay) {
+    overlay.begunAt = overlayClock();
+    overlay.vertices.clear();
+}
+
+void endOverlay(Overlay& overlay) {
+    overlay.buildSeconds = overlayClock() - overlay.begunAt;
+}
+
+//two triangles, pixels from the top left turned into clip space
+static void addQuad(Overlay& overlay, float x, float y, float width, float height, float u0, float v0, float u1, float v1, uint32_t color) {
+    float left = x * 2.0f / overlay.screenWidth - 1.0f;
+    float right = (x + width) * 2.0f / overlay.screenWidth - 1.0f;
+    float top = 1.0f - y * 2.0f / overlay.screenHeight;
+    float bottom = 1.0f - (y + height) * 2.0f / overlay.screenHeight;
+    OverlayVertex topLeft = { left, top, u0, v0, color };
+    OverlayVertex topRight = { right, top, u1, v0, color };
+    OverlayVertex bottomLeft = { left, bottom, u0, v1, color };
+    OverlayVertex bottomRight = { right, bottom, u1, v1, color };
+    std::vector<OverlayVertex>& vertices = overlay.vertices;
+    vertices.push_back(topLeft);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(topRight);
+    vertices.push_back(topRight);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(bottomRight);
+}
+
+void addRect(Overlay& overlay, float x, float y, float width, float height, uint32_t color) {
+    const GlyphAtlas& atlas = overlay.atlas;
+    addQuad(overlay, std::round(x), std::round(y), std::round(width), std::round(height), atlas.whiteU, atlas.whiteV, atlas.whiteU, atlas.whiteV, color);
+}
+
+//walks the text like addText, emit is called for every glyph with a bitmap
+template <typename Emit>
+static void layoutText(const GlyphAtlas& atlas, float x, float y, const char* text, float& width, float& height, Emit emit) {
+    float scale = (float)atlas.scale;
+    float startX = std::round(x), penX = startX;
+    float lineTop = std::round(y);
+    width = 0.0f;
+    for (const char* c = text; *c; ++c) {
+        unsigned char character = (unsigned char)*c;
+        if (character == '\n') {
+            width = std::max(width, penX - startX);
+            penX = startX;
+            lineTop += atlas.lineHeight * scale;
+            continue;
+        }
+        if (character < firstAtlasChar || character > lastAtlasChar) {
+            continue;
+        }
+        const Glyph& glyph = atlas.glyphs[character - firstAtlasChar];
+        if (glyph.width > 0 && glyph.height > 0) {
+            float baseline = lineTop + atlas.ascent * scale;
+            emit(glyph, penX + glyph.left * scale, baseline - glyph.top * scale, glyph.width * scale, glyph.height * scale);
+        }
+        penX += glyph.advance * scale;
+    }
+    width = std::max(width, penX - startX);
+    height = lineTop + atlas.lineHeight * scale - std::round(y);
+}
+
+float addText(Overlay& overlay, float x, float y, const char* text, uint32_t color) {
+    float width, height;
+    layoutText(overlay.atlas, x, y, text, width, height, [&overlay, color](const Glyph& glyph, float left, float top, float w, float h) {
+        addQuad(overlay, left, top, w, h, glyph.u0, glyph.v0, glyph.u1, glyph.v1, color);
+    });
+    return width;
+}
+
+void measureText(const GlyphAtlas& atlas, const char* text, float& width, float& height) {
+    layoutText(atlas, 0.0f, 0.0f, text, width, height, [](const Glyph&, float, float, float, float) {});
+}
+
+float overlayLineHeight(const GlyphAtlas& atlas) {
+    return (float)(atlas.lineHeight * atlas.scale);
+}
+
+void submitOverlay(Overlay& overlay, RenderQueue& queue) {
+    double uploadStart = overlayClock();
+    int count = (int)overlay.vertices.size();
+    overlay.stats.quads = count / 6;
+    if (count > 0) {
+        bindArrayBuffer(queue, overlay.buffer);
+        if (count > overlay.capacity) {
+            overlay.capacity = std::max(count, overlay.capacity * 2);
+            overlay.stats.bufferGrowths++;
+        }
+        //fresh storage every frame, the driver does not have to wait until last frame's draw has read the old one
+        glBufferData(GL_ARRAY_BUFFER, overlay.capacity * sizeof(OverlayVertex), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(OverlayVertex), overlay.vertices.data());
+
+        DrawPacket packet;
+        packet.key = makeSortKey(passOverlay, 0, 0, 0, 0.0f);
+        packet.kind = drawArrays;
+        packet.program = overlay.program.id;
+        packet.vao = overlay.vao;
+        packet.vertexCount = count;
+        packet.texture = overlay.atlas.texture;
+        submitDraw(queue, packet);
+    }
+    overlay.stats.microseconds = (overlay.buildSeconds + overlayClock() - uploadStart) * 1e6;
+}
+
+void deleteOverlay(Overlay& overlay) {
+    glDeleteTextures(1, &overlay.atlas.texture);
+    glDeleteBuffers(1, &overlay.buffer);
+    glDeleteVertexArrays(1, &overlay.vao);
+    glDeleteProgram(overlay.program.id);
+    overlay = Overlay();
+}
@@ -0,0 +1,72 @@
+#ifndef OVERLAY_HPP
+#define OVERLAY_HPP
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+#include <common/shader.hpp>
+
+#include "renderqueue.hpp"
+
+//Text and flat rectangles over the scene. The glyphs are rasterized once into an atlas texture, all strings and
+//rectangles of a frame are appended to one vertex array, streamed into one buffer and drawn with one call in passOverlay.
+//The glyphs come from a font file through FreeType (built with TANKS_FREETYPE), else from a built in 8x8 bitmap font.
+
+const int firstAtlasChar = 32, lastAtlasChar = 126; //printable ASCII, other characters are skipped
+
+struct Glyph {
+    float u0 = 0.0f, v0 = 0.0f, u1 = 0.0f, v1 = 0.0f;   //in the atlas, v0 is the top row
+    int width = 0, height = 0;                      //of the bitmap, atlas pixels
+    int left = 0, top = 0;                          //from the pen on the baseline to the bitmap's top left corner, top is up
+    int advance = 0;
+};
+
+struct GlyphAtlas {
+    GLuint texture = 0;                             //GL_R8, coverage of every texel
+    int width = 0, height = 0;
+    Glyph glyphs[lastAtlasChar - firstAtlasChar + 1];
+    float whiteU = 0.0f, whiteV = 0.0f;             //a fully covered texel, rectangles are textured with it
+    int scale = 1;                                  //screen pixels per atlas pixel, the 8x8 font is blown up
+    int ascent = 0, lineHeight = 0;                 //atlas pixels
+    bool fromFont = false;                          //false with the built in font
+};
+
+//one corner, the position already in clip space
+struct OverlayVertex {
+    float x, y;
+    float u, v;
+    uint32_t color;                                 //RGBA, one byte each in memory order, see overlayColor
+};
+
+struct OverlayStats {
+    int quads = 0;
+    int bufferGrowths = 0;                          //times the stream buffer needed more storage, since setup
+    double microseconds = 0.0;                      //building (beginOverlay to endOverlay) and uploading the last frame's
+};
+
+struct Overlay {
+    GlyphAtlas atlas;
+    ShaderProgram program;
+    GLuint vao = 0, buffer = 0;
+    int capacity = 0;                               //vertices the buffer has storage for
+    float screenWidth = 1.0f, screenHeight = 1.0f;
+    std::vector<OverlayVertex> vertices;            //the current frame's, keeps its memory
+    double begunAt = 0.0;
+    double buildSeconds = 0.0;
+    OverlayStats stats;
+};
+
+uint32_t overlayColor(float r, float g, float b, float a);
+
+bool setupOverlay(Overlay& overlay, const std::vector<const char*>& fontPaths, int pixelHeight, int screenWidth, int screenHeight); //<<< the first font that loads is used, the 8x8 font if none does. Binds outside the render queue, call it before the first frame. False if the shaders did not build
+void beginOverlay(Overlay& overlay); //<<< drops last frame's rectangles and text
+void endOverlay(Overlay& overlay); //<<< done adding for this frame, only times the building
+void addRect(Overlay& overlay, float x, float y, float width, float height, uint32_t color); //<<< pixels from the top left of the window
+float addText(Overlay& overlay, float x, float y, const char* text, uint32_t color); //<<< y is the top of the first line, '\n' starts the next one. Returns the width in pixels
+void measureText(const GlyphAtlas& atlas, const char* text, float& width, float& height); //<<< size addText would give the text, in pixels
+float overlayLineHeight(const GlyphAtlas& atlas); //<<< pixels
+void submitOverlay(Overlay& overlay, RenderQueue& queue); //<<< streams the vertices and submits the one draw, nothing if they are empty
+void deleteOverlay(Overlay& overlay);
+
+#endif
@@ -3,93 +3,163 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <common/shader.hpp>
 #include <map>
 
+#include "frustum.hpp"
+#include "gpuculling.hpp"
+#include "gputimers.hpp"
+#include "occlusion.hpp"
+#include "overlay.hpp"
+#include "renderqueue.hpp"
+#include "simulation.hpp"
+#include "simthread.hpp"
+#include "wallmesh.hpp"
+
 
 //Global Variables
 const unsigned int WIDTH = 2560, HEIGHT = 1440;     //Screen Size
-float platformSize = 120.0f;                        //Size of plattform 120x120
-float maxHeight = 5.0f;
 float cameraAngle = 0.0f;                           
 float rise = 10.0f;                                 //Determines how far the walls will rise in the pregame method
-bool isPlayerAlive = true;                          //used to end the game if player is hit
 int level = 1;                                      //determines current level is as of now useless (only one level)
-float cameraYaw = 0.0f;  
+uint64_t levelSeed = 1;                             //same seed, same walls and enemies
+const double maxFrameTime = 0.25;                   //after a longer hitch the simulation drops updates instead of running hundreds at once
+const double aiBudgetMicroseconds = 1000.0;         //enemy thinking per update, out of the 16.7 ms the simulation thread has for one
 glm::vec3 cameraOffset(0.0f, 1.5f, 0.0f);           //used to position the camera relative to the player
 
+//---------------------------------------------------Uniform blocks---------------------------------------------------//
+//Mirror the std140 blocks in the shaders member for member, a vec3 is padded to 16 bytes unless a float follows it.
+//Both are written once per frame into their own buffer, every program that declares the block reads it from there.
+const GLuint frameBlockBinding = 0;
+const GLuint lightBlockBinding = 1;
+
+//camera of the frame, block FrameData
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;                              //Position of the camera
+    float fogDensity;                               //only read by the shaderFog variant
+};
+
 //for the Shader
 struct SpotLight {
     glm::vec3 position;
-    glm::vec3 direction;
     float innerCone;
+    glm::vec3 direction;
     float outerCone;
     glm::vec3 diffuse;
+    float padding0;
     glm::vec3 specular;
+    float padding1;
     glm::vec3 ambient;
+    float padding2;
+};
+
+//lights of the frame, block LightData
+struct LightBlock {
+    glm::vec3 lightPos;
+    float ambientStrength;
+    float specularStrength;
+    float shininess;
+    float lightIntensity;
+    float padding;
+    SpotLight spotLight;
 };
 
-//Used for players and enemies
-struct cube {
-    float x, z;
-    float rotation;
-    float speed;
-    float lastShotTime = 0.0f;
-    float shootCooldown = 5.0f;
+static_assert(sizeof(FrameBlock) == 144, "FrameBlock has to match the std140 layout of FrameData");
+static_assert(sizeof(LightBlock) == 112, "LightBlock has to match the std140 layout of LightData");
+
+GLuint frameUBO, lightUBO;
+
+GLuint VAO[2], VBO[2], EBO[2];
+GLuint instanceVBO;                                 //per instance data for all VAOs, refilled every frame
+GLuint wallVAO, wallVBO, wallEBO;                   //the baked walls of the level
+GLsizei wallIndexCount = 0;
+std::vector<WallChunk> wallChunks;                  //parts of the wall mesh that are culled on their own
+WallMesh wallMesh;                                  //kept on the CPU, its nearest chunks are the occluders
+CullStats cullStats;                                //what the last frame's culling kept
+
+//The scene shaders are compiled once per combination of these, each program only holds the code of its features.
+//The pregame draws with no features, plain colors without lighting.
+enum ShaderFeature {
+    shaderLit = 1,                                  //spotlight of the player
+    shaderFog = 2,                                  //darkens with the distance from the camera
 };
 
-//for the walls
-struct wall {
-    float x, z, h;
+ShaderVariants sceneShaders;
+
+//Every draw goes through the queue, the program slot of a packet is its feature bits.
+//Meshes in the order the queue draws them: the walls hide the most, the platform is behind everything else.
+enum MeshSlot {
+    meshWalls = 0,
+    meshCube = 1,
+    meshPlatform = 2,
 };
 
-//for bullets
-struct bullet {
-    float x, z;
-    float rotation;
-    int bounce;                                     //all bullets can collide with one wall and bounce instead of being destroyed
-    bool enemy;                                     //so the shooter of the bullet doesnt instantly collide with his own bullet
-    std::vector<std::pair<float, float>> collidedWalls;     //to stop double collisions with the same wall
+//the material slot says which buffer the instances come from
+enum InstanceSource {
+    instancesOfFrame = 0,                           //instanceVBO, filled by uploadInstances
+    instancesGpuCulled = 1,                         //gpuCulling.visibleInstances
 };
 
-GLuint VAO[2], VBO[2], EBO[2];
-GLuint shaderProgram;
-GLuint rectVAO, rectVBO, rectEBO;
-GLuint textVAO, textVBO;
+RenderQueue renderQueue;
+GpuTimers gpuTimers;                                //GL timer queries of the profiler, see writeTrace
+Overlay overlay;                                    //stats over the scene, drawn in the queue's overlay pass
 
 //reads playerinput
-void processInput(GLFWwindow* window, cube& player, std::vector<bullet>& bullets, float currentTime) {
+TickInput readInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)       //rotates playercube to the left
-        player.rotation -= 1.0f;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)       //rotates playercube to the right
-        player.rotation += 1.0f;
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {     //move forward
-        player.x += player.speed * sin(glm::radians(player.rotation));//calculates how the player has to move forward
-        player.z -= player.speed * cos(glm::radians(player.rotation));
-    }
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {     //move backwards
-        player.x -= player.speed * sin(glm::radians(player.rotation));//calculates how the player has to move backwards
-        player.z += player.speed * cos(glm::radians(player.rotation));
-    }
+    TickInput input;
+    input.turnLeft = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;      //rotates playercube to the left
+    input.turnRight = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;     //rotates playercube to the right
+    input.forward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;       //move forward
+    input.backward = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;      //move backwards
+    input.lookLeft = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;      //turns view to the left
+    input.lookRight = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;     //turns view to the right
+    input.shoot = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;     //shoot bullet
+    return input;
+}
 
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {     //turns view to the left
-        cameraYaw -= 1.0f;  
-    }
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {     //turns view to the right
-        cameraYaw += 1.0f; 
-    }
+void setupUniformBlocks() {
+    glGenBuffers(1, &frameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frameBlockBinding, frameUBO);
 
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && (currentTime - player.lastShotTime) > player.shootCooldown) {   //shoot bullet
-        float shootAngle = player.rotation + cameraYaw;                         //calculates at which angle the bullet should be shot
-        bullets.push_back({ player.x, player.z, shootAngle, 1, false });            
-        player.lastShotTime = currentTime;
+    glGenBuffers(1, &lightUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, lightUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, lightBlockBinding, lightUBO);
+}
+
+//connects the blocks a program declares to the shared buffers, programs without them are left alone
+void bindUniformBlocks(ShaderProgram& program) {
+    BindUniformBlock(program, "FrameData", frameBlockBinding);
+    BindUniformBlock(program, "LightData", lightBlockBinding);
+}
+
+//the variant for these features, a variant that was just built gets connected to the uniform blocks first
+ShaderProgram& sceneShader(unsigned int features) {
+    bool built;
+    ShaderProgram& program = GetShaderVariant(sceneShaders, features, &built);
+    if (built) {
+        bindUniformBlocks(program);
     }
+    return program;
+}
 
+//blocks that hold the same bytes as last frame are not uploaded again
+void uploadUniformBlocks(const FrameBlock& frame, const LightBlock& light) {
+    uploadUniformBlock(renderQueue, frameUBO, &frame, sizeof(FrameBlock));
+    uploadUniformBlock(renderQueue, lightUBO, &light, sizeof(LightBlock));
 }
 
 GLuint compileShader(GLenum type, const char* source) {
@@ -108,32 +178,86 @@ GLuint compileShader(GLenum type, const char* source) {
     return shader;
 }
 
-void setupPlatformAndCube() {
+//one corner of a mesh, interleaved so a vertex is read from one place
+struct Vertex {
+    glm::vec3 position;                             //location 0
+    glm::vec3 normal;                               //location 1, before the instance's rotation and scale
+};
+
+//per vertex attributes 0 and 1 from the Vertex buffer bound to GL_ARRAY_BUFFER, for the bound vao
+void enableVertexAttributes() {
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(1);
+}
+
+//attributes 2-4 come from the instance buffer and advance once per instance instead of per vertex
+void enableInstanceAttributes(GLuint vao) {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (int attribute = 2; attribute <= 4; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+}
+
+void setupPlatformAndCube(float platformSize) {
 
     float platform = platformSize / 2.0f;
 
+    //position, normal, counter clockwise seen from above
     float platformVertices[] = {
-        -platform, 0.0f, -platform,
-         platform, 0.0f, -platform,
-         platform, 0.0f,  platform,
-        -platform, 0.0f,  platform,
+        -platform, 0.0f,  platform,   0.0f, 1.0f, 0.0f,
+         platform, 0.0f,  platform,   0.0f, 1.0f, 0.0f,
+         platform, 0.0f, -platform,   0.0f, 1.0f, 0.0f,
+        -platform, 0.0f, -platform,   0.0f, 1.0f, 0.0f,
     };
     unsigned int platformIndices[] = {
         0, 1, 2, 2, 3, 0
     };
 
+    //every face has its own 4 corners so it gets its own normal, counter clockwise seen from outside
     float cubeVertices[] = {
-        -0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f,
-        -0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f
-    };
-    unsigned int cubeIndices[] = {
-        0, 1, 2, 2, 3, 0,
-        4, 5, 6, 6, 7, 4,
-        0, 4, 7, 7, 3, 0,
-        1, 5, 6, 6, 2, 1,
-        3, 2, 6, 6, 7, 3,
-        0, 1, 5, 5, 4, 0
+        //front, +z
+        -0.5f, -0.5f,  0.5f,   0.0f,  0.0f,  1.0f,
+         0.5f, -0.5f,  0.5f,   0.0f,  0.0f,  1.0f,
+         0.5f,  0.5f,  0.5f,   0.0f,  0.0f,  1.0f,
+        -0.5f,  0.5f,  0.5f,   0.0f,  0.0f,  1.0f,
+        //back, -z
+        -0.5f,  0.5f, -0.5f,   0.0f,  0.0f, -1.0f,
+         0.5f,  0.5f, -0.5f,   0.0f,  0.0f, -1.0f,
+         0.5f, -0.5f, -0.5f,   0.0f,  0.0f, -1.0f,
+        -0.5f, -0.5f, -0.5f,   0.0f,  0.0f, -1.0f,
+        //left, -x
+        -0.5f, -0.5f,  0.5f,  -1.0f,  0.0f,  0.0f,
+        -0.5f,  0.5f,  0.5f,  -1.0f,  0.0f,  0.0f,
+        -0.5f,  0.5f, -0.5f,  -1.0f,  0.0f,  0.0f,
+        -0.5f, -0.5f, -0.5f,  -1.0f,  0.0f,  0.0f,
+        //right, +x
+         0.5f, -0.5f, -0.5f,   1.0f,  0.0f,  0.0f,
+         0.5f,  0.5f, -0.5f,   1.0f,  0.0f,  0.0f,
+         0.5f,  0.5f,  0.5f,   1.0f,  0.0f,  0.0f,
+         0.5f, -0.5f,  0.5f,   1.0f,  0.0f,  0.0f,
+        //top, +y
+        -0.5f,  0.5f, -0.5f,   0.0f,  1.0f,  0.0f,
+        -0.5f,  0.5f,  0.5f,   0.0f,  1.0f,  0.0f,
+         0.5f,  0.5f,  0.5f,   0.0f,  1.0f,  0.0f,
+         0.5f,  0.5f, -0.5f,   0.0f,  1.0f,  0.0f,
+        //bottom, -y
+         0.5f, -0.5f, -0.5f,   0.0f, -1.0f,  0.0f,
+         0.5f, -0.5f,  0.5f,   0.0f, -1.0f,  0.0f,
+        -0.5f, -0.5f,  0.5f,   0.0f, -1.0f,  0.0f,
+        -0.5f, -0.5f, -0.5f,   0.0f, -1.0f,  0.0f,
     };
+    static_assert(sizeof(cubeVertices) == 24 * sizeof(Vertex), "cube needs 4 vertices per face");
+    unsigned int cubeIndices[36];
+    for (unsigned int face = 0; face < 6; ++face) {
+        const unsigned int quad[6] = { 0, 1, 2, 2, 3, 0 };
+        for (int i = 0; i < 6; ++i) {
+            cubeIndices[face * 6 + i] = face * 4 + quad[i];
+        }
+    }
 
     glGenVertexArrays(2, VAO);
     glGenBuffers(2, VBO);
@@ -144,456 +268,512 @@ void setupPlatformAndCube() {
     glBufferData(GL_ARRAY_BUFFER, sizeof(platformVertices), platformVertices, GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO[0]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(platformIndices), platformIndices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    enableVertexAttributes();
 
     glBindVertexArray(VAO[1]);
     glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO[1]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-}
+    enableVertexAttributes();
 
-//Renders game
-void renderScene(cube player, const std::vector<wall>& walls, std::vector<bullet>& bullets, std::vector<cube> enemies) {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(shaderProgram);
-
-    glm::vec3 playerPosition(player.x, 0.5f, player.z);
+    glGenBuffers(1, &instanceVBO);
+    enableInstanceAttributes(VAO[0]);
+    enableInstanceAttributes(VAO[1]);
+    glBindVertexArray(0);
+}
 
-    //player view
-    glm::vec3 cameraPosition = playerPosition + cameraOffset;
-    glm::vec3 direction(
-        sin(glm::radians(player.rotation + cameraYaw)),  
-        0.0f,  
-        -cos(glm::radians(player.rotation + cameraYaw)) 
-    );
+//uploads the level's walls as one static mesh, they don't move after this
+void setupWallMesh(const std::vector<wall>& walls, const RoomGraph& rooms) {
+    //walls are baked per room, so a room hidden behind other walls can be skipped as a whole
+    std::vector<int> regions(walls.size());
+    for (size_t i = 0; i < walls.size(); ++i) {
+        bool onBoundary;
+        regions[i] = roomOfPoint(rooms, walls[i].x, walls[i].z, onBoundary);
+    }
+    WallMesh mesh = bakeWallMesh(walls, regions);
+    wallIndexCount = (GLsizei)mesh.indices.size();
+    wallChunks = mesh.chunks;
+    wallMesh = mesh;
+    std::cout << "Wall mesh: " << walls.size() << " walls, " << mesh.indices.size() / 3 << " triangles instead of " << walls.size() * 12 << std::endl;
+
+    glGenVertexArrays(1, &wallVAO);
+    glGenBuffers(1, &wallVBO);
+    glGenBuffers(1, &wallEBO);
+    std::vector<Vertex> vertices(mesh.positions.size() / 3);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].position = glm::make_vec3(&mesh.positions[i * 3]);
+        vertices[i].normal = glm::make_vec3(&mesh.normals[i * 3]);
+    }
+    glBindVertexArray(wallVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, wallVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, wallEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+    enableVertexAttributes();
+    enableInstanceAttributes(wallVAO);
+    glBindVertexArray(0);
+}
 
-    glm::mat4 view = glm::lookAt(
-        cameraPosition,
-        cameraPosition + direction,
-        glm::vec3(0.0f, 1.0f, 0.0f)  
-    );
+//---------------------------------------------------Instanced rendering---------------------------------------------------//
+//one object drawn with the shared platform or cube mesh, the vertex shader builds the model matrix from this
+struct CubeInstance {
+    glm::vec3 position;
+    float yaw;                                      //radians around the y axis
+    glm::vec3 scale;
+    glm::vec4 color;
+};
 
-    glm::mat4 projection = glm::perspective(glm::radians(70.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+//the instances of one object type, a range in the instance buffer drawn with a single call
+struct InstanceBatch {
+    int first = 0;
+    int count = 0;
+};
 
+const glm::vec4 platformColor(0.24f, 0.39f, 0.18f, 1.0f);
+const glm::vec4 playerColor(0.1f, 0.4f, 0.8f, 1.0f);
+const glm::vec4 enemyColor(0.412f, 0.412f, 0.412f, 1.0f);
+const glm::vec4 wallColor(0.54f, 0.27f, 0.07f, 1.0f);
+const glm::vec4 bulletColor(1.0f, 0.2f, 0.2f, 1.0f);
 
-    //spotlight
-    glm::vec3 lightPos = glm::vec3(player.x, 5.0f, player.z);
-    glm::vec3 viewPos(40.0f * sin(glm::radians(cameraAngle)), 40.0f, 40.0f * cos(glm::radians(cameraAngle)));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(lightPos));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(viewPos));
-    glUniform1f(glGetUniformLocation(shaderProgram, "ambientStrength"), 0.2f);
-    glUniform1f(glGetUniformLocation(shaderProgram, "specularStrength"), 0.5f);
-    glUniform1f(glGetUniformLocation(shaderProgram, "shininess"), 10.0f);
-    glUniform1f(glGetUniformLocation(shaderProgram, "lightIntensity"), 1.0f);
+std::vector<CubeInstance> instances;                //collected every frame, kept so it doesn't allocate again
 
-    SpotLight spotLight;
-    spotLight.position = glm::vec3(player.x, 0.0f, player.z);  
-    float rad = glm::radians(player.rotation + cameraYaw);    
+//the GPU culling path uploads instances as plain floats, see FrustumCull.computeshader
+static_assert(sizeof(CubeInstance) == 11 * sizeof(float), "CubeInstance has to be tightly packed floats");
 
-    spotLight.direction = glm::normalize(glm::vec3(sin(-rad), 0.0f, cos(rad)));
-    spotLight.innerCone = cos(glm::radians(12.5f));
-    spotLight.outerCone = cos(glm::radians(30.5f));
-    spotLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
-    spotLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
-    spotLight.ambient = glm::vec3(0.2f, 0.2f, 0.2f);
+InstanceBatch beginBatch() {
+    InstanceBatch batch;
+    batch.first = (int)instances.size();
+    return batch;
+}
 
-    glUniform3fv(glGetUniformLocation(shaderProgram, "u_spot_light.position"), 1, glm::value_ptr(spotLight.position));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "u_spot_light.direction"), 1, glm::value_ptr(spotLight.direction));
-    glUniform1f(glGetUniformLocation(shaderProgram, "u_spot_light.innerCone"), spotLight.innerCone);
-    glUniform1f(glGetUniformLocation(shaderProgram, "u_spot_light.outerCone"), spotLight.outerCone);
-    glUniform3fv(glGetUniformLocation(shaderProgram, "u_spot_light.diffuse"), 1, glm::value_ptr(spotLight.diffuse));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "u_spot_light.specular"), 1, glm::value_ptr(spotLight.specular));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "u_spot_light.ambient"), 1, glm::value_ptr(spotLight.ambient));
+void endBatch(InstanceBatch& batch) {
+    batch.count = (int)instances.size() - batch.first;
+}
 
-    //platform
-    glBindVertexArray(VAO[0]);
-    glm::mat4 model = glm::mat4(1.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), 0.24f, 0.39f, 0.18f, 1.0f);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+void addInstance(glm::vec3 position, float yaw, glm::vec3 scale, glm::vec4 color) {
+    instances.push_back({ position, yaw, scale, color });
+}
 
-    //player
-    glBindVertexArray(VAO[1]);
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(player.x, 0.5f, player.z));
-    model = glm::rotate(model, glm::radians(-player.rotation), glm::vec3(0.0f, 1.0f, 0.0f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), 0.1f, 0.4f, 0.8f, 1.0f);
-    glUniform1f(glGetUniformLocation(shaderProgram, "playerDistance"), glm::length(playerPosition));
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-
-    //enemies
-    if (!enemies.empty()) {
-        auto enemyIt = enemies.begin();
-        while (enemyIt != enemies.end()) {
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(enemyIt->x, 0.5f, enemyIt->z));
-            model = glm::rotate(model, glm::radians(-enemyIt->rotation), glm::vec3(0.0f, 1.0f, 0.0f));
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), 0.412f, 0.412f, 0.412f, 1.0f);
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-            ++enemyIt;
-        }
+//player and enemies are unit cubes standing on the platform, turned like their rotation
+InstanceBatch addTanks(const cube* tanks, int count, glm::vec4 color) {
+    InstanceBatch batch = beginBatch();
+    for (int i = 0; i < count; ++i) {
+        addInstance(glm::vec3(tanks[i].x, 0.5f, tanks[i].z), glm::radians(-tanks[i].rotation), glm::vec3(1.0f), color);
     }
+    endBatch(batch);
+    return batch;
+}
 
-    //walls
-    for (const wall& w : walls) {
-        glm::vec3 wallPosition(w.x, w.h / 2.0f, w.z);
-        model = glm::translate(glm::mat4(1.0f), wallPosition);
-        model = glm::scale(model, glm::vec3(1.0f, w.h, 1.0f));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), 0.54f, 0.27f, 0.07f, 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "playerDistance"), glm::length(playerPosition - wallPosition));
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    }
+//the baked walls are a single instance, offsetY lowers them for the rise in the pregame
+InstanceBatch addWallMesh(float offsetY) {
+    InstanceBatch batch = beginBatch();
+    addInstance(glm::vec3(0.0f, offsetY, 0.0f), 0.0f, glm::vec3(1.0f), wallColor);
+    endBatch(batch);
+    return batch;
+}
 
-    //bullets
-    for (const bullet& b : bullets) {
-        glm::vec3 bulletPosition(b.x, 0.5f, b.z);
-        model = glm::translate(glm::mat4(1.0f), bulletPosition);
-        model = glm::scale(model, glm::vec3(0.2f));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), 1.0f, 0.2f, 0.2f, 1.0f); 
-        glUniform1f(glGetUniformLocation(shaderProgram, "playerDistance"), glm::length(playerPosition - bulletPosition));
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    }
+void uploadInstances() {
+    bindArrayBuffer(renderQueue, instanceVBO);
+    //new storage every frame, so the driver doesn't have to wait for last frame's draws still reading the old one
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CubeInstance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(CubeInstance), instances.data());
 }
 
-//---------------------------------------------------Collsision Methods---------------------------------------------------//
-void updateBullets(std::vector<bullet>& bullets, const std::vector<wall>& walls, float platformSize, std::vector<cube>& enemies, cube player, float bulletSpeed) {
-    float border = platformSize / 2.0f;
-    float wallSize = 0.5f;
-    float bulletSize = 0.2f;
-    float cSize = 0.5f;
+//points the instance attributes of the bound vao at the instances in buffer starting with first
+void pointInstanceAttributes(GLuint buffer, int first) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    const char* base = (const char*)(first * sizeof(CubeInstance));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), base + offsetof(CubeInstance, position));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), base + offsetof(CubeInstance, scale));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), base + offsetof(CubeInstance, color));
+}
 
-    // Used to track what should be deleted. Directly deleting enemies/bullets caused issues.
-    std::vector<int> enemiesToRemove;
-    std::vector<int> bulletsToRemove;
+GLuint meshVAO(MeshSlot mesh) {
+    return mesh == meshWalls ? wallVAO : (mesh == meshCube ? VAO[1] : VAO[0]);
+}
 
-    for (int i = 0; i < bullets.size(); ++i) {
-        auto& b = bullets[i];
-        b.x += bulletSpeed * sin(glm::radians(b.rotation));     //calculates x and z speed
-        b.z -= bulletSpeed * cos(glm::radians(b.rotation));
+GLsizei meshIndexCount(MeshSlot mesh) {
+    return mesh == meshWalls ? wallIndexCount : (mesh == meshCube ? 36 : 6);
+}
 
-        bool bounced = false;
+//distance from the eye to the nearest instance of the batch, sorts the packets front to back
+float nearestInstance(const float eye[3], InstanceBatch batch) {
+    float nearest = 1e30f;
+    for (int i = batch.first; i < batch.first + batch.count; ++i) {
+        nearest = std::min(nearest, glm::distance(glm::make_vec3(eye), instances[i].position));
+    }
+    return nearest;
+}
 
-        //Checks collision with platform borders
-        if (b.x <= -border || b.x >= border) {                 
-            b.rotation = -b.rotation;
-            bounced = true;
-        }
-        if (b.z <= -border || b.z >= border) {
-            b.rotation = 180.0f - b.rotation;
-            bounced = true;
-        }
+//distance from the eye to the nearest point of the box, 0 inside it
+float boxDistance(const float eye[3], const float boxMin[3], const float boxMax[3]) {
+    glm::vec3 point = glm::clamp(glm::make_vec3(eye), glm::make_vec3(boxMin), glm::make_vec3(boxMax));
+    return glm::distance(glm::make_vec3(eye), point);
+}
 
-        //checks for collisions with walls
-        for (const wall& w : walls) {
-            bool collisionX = b.x > w.x - wallSize && b.x < w.x + wallSize;
-            bool collisionZ = b.z > w.z - wallSize && b.z < w.z + wallSize;
-
-            if (collisionX && collisionZ) {             //checks if the bullet collided with a wall and flips the speed accordingly
-                float overlapX = std::abs(b.x - w.x);
-                float overlapZ = std::abs(b.z - w.z);
-                if (overlapX > overlapZ) {
-                    b.rotation = -b.rotation;
-                }
-                else {
-                    b.rotation = 180.0f - b.rotation;
-                }
-                bounced = true;
-                break;
-            }
-        }
+//one instanced draw of the batch with the mesh and the scene shader with these features
+void submitInstances(unsigned int features, MeshSlot mesh, InstanceBatch batch, float depth) {
+    if (batch.count == 0) {
+        return;
+    }
+    DrawPacket packet;
+    packet.key = makeSortKey(passOpaque, features, mesh, instancesOfFrame, depth);
+    packet.program = sceneShader(features).id;
+    packet.vao = meshVAO(mesh);
+    packet.instanceBuffer = instanceVBO;
+    packet.firstInstance = batch.first;
+    packet.indexCount = meshIndexCount(mesh);
+    packet.instanceCount = batch.count;
+    submitDraw(renderQueue, packet);
+}
 
-        //checks player bullet collision
-        if (!b.enemy) {
-            for (int j = 0; j < enemies.size(); ++j) {
-                float distanceX = b.x - enemies[j].x;
-                float distanceZ = b.z - enemies[j].z;
-                float distance = sqrt(distanceX * distanceX + distanceZ * distanceZ);
-
-                if (distance < (bulletSize + cSize)) {
-                    enemiesToRemove.push_back(j);  
-                    bulletsToRemove.push_back(i);  
-                    break;
-                }
-            }
+//only the given wall chunks that were not found hidden, chunks next to each other in the index buffer are drawn as one range
+void submitVisibleWalls(unsigned int features, InstanceBatch batch, const std::vector<int>& chunks, const std::vector<char>& visible, const float eye[3]) {
+    DrawPacket packet;
+    packet.firstRange = (int)renderQueue.rangeCounts.size();
+    int rangeEnd = -1;
+    float nearest = 1e30f;
+    cullStats.chunksVisible = 0;
+    cullStats.chunksTotal = (int)wallChunks.size();
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (!visible[i]) {
+            continue;
         }
-
-        //checks enemy bullet collision
-        if (b.enemy) {
-            float distanceToPlayerX = b.x - player.x;
-            float distanceToPlayerZ = b.z - player.z;
-            float distanceToPlayer = sqrt(distanceToPlayerX * distanceToPlayerX + distanceToPlayerZ * distanceToPlayerZ);
-
-            if (distanceToPlayer < (bulletSize + 0.5f)) {
-                isPlayerAlive = false;
-                bulletsToRemove.push_back(i);  
-            }
+        const WallChunk& chunk = wallChunks[chunks[i]];
+        cullStats.chunksVisible++;
+        nearest = std::min(nearest, boxDistance(eye, chunk.boxMin, chunk.boxMax));
+        if (chunk.firstIndex == rangeEnd) {
+            renderQueue.rangeCounts.back() += chunk.indexCount;
         }
-
-        if (bounced) {
-            if (b.bounce > 0) {
-                b.bounce--;
-            }
-            else {
-                bulletsToRemove.push_back(i);  
-            }
+        else {
+            addRange(renderQueue, chunk.indexCount, chunk.firstIndex);
         }
+        rangeEnd = chunk.firstIndex + chunk.indexCount;
     }
-
-    //deletes the bullets and enemies
-    for (int i = bulletsToRemove.size() - 1; i >= 0; --i) {
-        bullets.erase(bullets.begin() + bulletsToRemove[i]);
-    }
-
-
-    for (int i = enemiesToRemove.size() - 1; i >= 0; --i) {
-        enemies.erase(enemies.begin() + enemiesToRemove[i]);
+    packet.rangeCount = (int)renderQueue.rangeCounts.size() - packet.firstRange;
+    if (packet.rangeCount == 0) {
+        return;
     }
+    packet.key = makeSortKey(passOpaque, features, meshWalls, instancesOfFrame, nearest);
+    packet.kind = drawRanges;
+    packet.program = sceneShader(features).id;
+    packet.vao = wallVAO;
+    packet.instanceBuffer = instanceVBO;
+    packet.firstInstance = batch.first;
+    submitDraw(renderQueue, packet);
 }
 
-void checkPlayerCollision(cube& player, const std::vector<wall>& walls) {
-    float border = platformSize / 2.0f;     //is halved because the border is from -60 to 60 and not from 0 to 120
-    float playerSize = 0.5f;
-    float wallSize = 0.5f;
+//---------------------------------------------------Occlusion culling---------------------------------------------------//
+//A frame is prepared before the updates of the next one run: frustum and portals pick the candidates,
+//then the worker tests them against the nearest walls while the main thread simulates.
+//drawScene waits for it, so the picture is one frame behind the simulation.
+OcclusionWorker occlusionWorker;
+OcclusionStats occlusionStats;                      //what the last frame's occlusion test did
+
+//With GPU culling on (key G, needs GL 4.3) nothing is culled here: enemies and bullets are handed over as they are
+//and a compute shader tests them and the wall chunks against the frustum, portals and occlusion are skipped.
+GpuCulling gpuCulling;
+bool useGpuCulling = false;
+
+struct SceneFrame {
+    FrameBlock frame;
+    LightBlock light;
+    CubeInstance player;
+    std::vector<CubeInstance> candidates;           //enemies and bullets in the order of the job's boxes
+    int enemyCount = 0;                             //the first candidates are enemies, the rest bullets
+    int enemiesTotal = 0, bulletsTotal = 0;
+    OcclusionJob job;
+    bool gpuCulled = false;                         //culled by runGpuCulling in drawScene instead of the job
+    Frustum frustum;
+    float eye[3];                                   //camera position, the draws are sorted by their distance to it
+};
 
-    glm::mat4 model = glm::mat4(1.0f);
+SceneFrame sceneFrame;
 
-    if (player.x <= -border + 0.5f) player.x = -border + 0.5f;
+static void addCandidate(SceneFrame& scene, glm::vec3 position, float yaw, glm::vec3 scale, glm::vec4 color, const float halfSize[3]) {
+    scene.candidates.push_back({ position, yaw, scale, color });
+    const float box[6] = { position.x - halfSize[0], position.y - halfSize[1], position.z - halfSize[2],
+                           position.x + halfSize[0], position.y + halfSize[1], position.z + halfSize[2] };
+    scene.job.boxes.insert(scene.job.boxes.end(), box, box + 6);
+}
 
-    if (player.x >= border - 0.5f)  player.x = border - 0.5f;
+//Culls the snapshot alpha of the way from its previous to its current update and starts the occlusion test on the worker
+void prepareScene(const GameSnapshot& snapshot, const RoomGraph& rooms, float alpha) {
+    PROFILE_SCOPE("prepareScene");
+    SceneFrame& scene = sceneFrame;
+    cube player = interpolate(snapshot.player, alpha);
+    static std::vector<cube> enemies;
+    enemies.resize(snapshot.enemies.size());
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        enemies[i] = interpolate(snapshot.enemies[i], alpha);
+    }
+    float viewYaw = glm::mix(snapshot.prevCameraYaw, snapshot.cameraYaw, alpha);
+    const int bulletCount = (int)snapshot.bulletX.size();
 
+    glm::vec3 playerPosition(player.x, 0.5f, player.z);
 
+    //player view
+    glm::vec3 cameraPosition = playerPosition + cameraOffset;
+    glm::vec3 direction(
+        sin(glm::radians(player.rotation + viewYaw)),  
+        0.0f,  
+        -cos(glm::radians(player.rotation + viewYaw)) 
+    );
 
-    if (player.z <= -border + 0.5f) player.z = -border + 0.5f;
+    glm::mat4 view = glm::lookAt(
+        cameraPosition,
+        cameraPosition + direction,
+        glm::vec3(0.0f, 1.0f, 0.0f)  
+    );
 
-    if (player.z >= border - 0.5f)  player.z = border - 0.5f;
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+    FrameBlock& frame = scene.frame;
+    frame.view = view;
+    frame.projection = projection;
+    frame.viewPos = glm::vec3(40.0f * sin(glm::radians(cameraAngle)), 40.0f, 40.0f * cos(glm::radians(cameraAngle)));
+    frame.fogDensity = 0.0f;
 
-    //checks player wall collision
-    for (const wall& w : walls) {
-        bool collisionX = player.x + playerSize > w.x - wallSize && player.x - playerSize < w.x + wallSize;
-        bool collisionZ = player.z + playerSize > w.z - wallSize && player.z - playerSize < w.z + wallSize;
+    //spotlight
+    LightBlock& light = scene.light;
+    light = LightBlock();
+    light.lightPos = glm::vec3(player.x, 5.0f, player.z);
+    light.ambientStrength = 0.2f;
+    light.specularStrength = 0.5f;
+    light.shininess = 10.0f;
+    light.lightIntensity = 1.0f;
+
+    SpotLight& spotLight = light.spotLight;
+    spotLight.position = glm::vec3(player.x, 0.0f, player.z);  
+    float rad = glm::radians(player.rotation + viewYaw);    
 
-        if (collisionX && collisionZ) {
-            
-            float overlapX = (playerSize + wallSize) - std::abs(player.x - w.x);
-            float overlapZ = (playerSize + wallSize) - std::abs(player.z - w.z);
+    spotLight.direction = glm::normalize(glm::vec3(sin(-rad), 0.0f, cos(rad)));
+    spotLight.innerCone = cos(glm::radians(12.5f));
+    spotLight.outerCone = cos(glm::radians(30.5f));
+    spotLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+    spotLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    spotLight.ambient = glm::vec3(0.2f, 0.2f, 0.2f);
 
-            if (overlapX < overlapZ) {
-  
-                if (player.x < w.x) {
-                    player.x -= overlapX; 
-                }
-                else {
-                    player.x += overlapX; 
-                }
-            }
-            else {
-
-                if (player.z < w.z) {
-                    player.z -= overlapZ; 
-                }
-                else {
-                    player.z += overlapZ; 
-                }
-            }
+    //the player itself is always drawn
+    scene.player = { playerPosition, glm::radians(-player.rotation), glm::vec3(1.0f), playerColor };
+
+    glm::mat4 viewProjection = projection * view;
+    Frustum frustum = extractFrustum(glm::value_ptr(viewProjection));
+    scene.frustum = frustum;
+    scene.eye[0] = cameraPosition.x;
+    scene.eye[1] = cameraPosition.y;
+    scene.eye[2] = cameraPosition.z;
+    scene.enemiesTotal = (int)enemies.size();
+    scene.bulletsTotal = bulletCount;
+    scene.candidates.clear();
+    scene.gpuCulled = useGpuCulling;
+    if (scene.gpuCulled) {
+        for (const cube& enemy : enemies) {
+            scene.candidates.push_back({ glm::vec3(enemy.x, 0.5f, enemy.z), glm::radians(-enemy.rotation), glm::vec3(1.0f), enemyColor });
         }
+        scene.enemyCount = (int)enemies.size();
+        for (int i = 0; i < bulletCount; ++i) {
+            glm::vec3 position(glm::mix(snapshot.bulletPrevX[i], snapshot.bulletX[i], alpha), 0.5f, glm::mix(snapshot.bulletPrevZ[i], snapshot.bulletZ[i], alpha));
+            scene.candidates.push_back({ position, 0.0f, glm::vec3(0.2f), bulletColor });
+        }
+        return;
     }
-}
-
-//---------------------------------------------------Methods to build structures---------------------------------------------------//
-bool hasLineOfSight(cube enemy, cube player, const std::vector<wall>& walls) {
-    glm::vec2 enemyPos(enemy.x, enemy.z);
-    glm::vec2 playerPos(player.x, player.z);
-    glm::vec2 direction = glm::normalize(playerPos - enemyPos);
-    float distance = glm::length(playerPos - enemyPos);
 
-    float stepSize = 0.5f;
-    glm::vec2 currentPos = enemyPos;
-    //steps from enemy to the player to check if there is a wall between them
-    while (glm::length(currentPos - enemyPos) < distance) {
-        currentPos += direction * stepSize;
-        for (const wall& w : walls) {
-            glm::vec2 wallPos(w.x, w.z);
-            float wallRadius = 0.5f;
-
-            if (glm::length(currentPos - wallPos) < wallRadius) {
-                return false;
+    //only what is inside the view and not hidden behind the walls of a room is a candidate
+    const float eye[3] = { cameraPosition.x, cameraPosition.y, cameraPosition.z };
+    static RoomVisibility roomVisibility;
+    findVisibleRooms(rooms, frustum, eye, roomVisibility);
+    static std::vector<float> cullX, cullZ;
+    static std::vector<int> visible;
+
+    //keeps the boxes the frustum test let through that are also seen through the portals
+    auto cullHidden = [&](int count, float centerY, const float halfSize[3]) {
+        int kept = 0;
+        for (int i = 0; i < count; ++i) {
+            float x = cullX[visible[i]], z = cullZ[visible[i]];
+            const float boxMin[3] = { x - halfSize[0], centerY - halfSize[1], z - halfSize[2] };
+            const float boxMax[3] = { x + halfSize[0], centerY + halfSize[1], z + halfSize[2] };
+            bool onBoundary;
+            int room = roomOfPoint(rooms, x, z, onBoundary);
+            if (boxVisibleInRoom(roomVisibility, room, onBoundary, boxMin, boxMax)) {
+                visible[kept++] = visible[i];
             }
         }
-    }
-    return true;
-}
-
-void enemyShootAtPlayer(std::vector<cube>& enemies, cube player, std::vector<bullet>& bullets, const std::vector<wall>& walls, float currentTime) {
-    for (cube& enemy : enemies) {
-#
-        //rotates enemy towards player
-        float deltaX = player.x - enemy.x;
-        float deltaZ = player.z - enemy.z;
-
-        float angle = atan2(deltaX, -deltaZ);
-        enemy.rotation = glm::degrees(angle);
+        return kept;
+    };
 
-        if (hasLineOfSight(enemy, player, walls) && (currentTime - enemy.lastShotTime) > enemy.shootCooldown) {         //if the enemy has line of sight it shoots a bullet towards the players current location
-            bullets.push_back({ enemy.x, enemy.z, enemy.rotation, 1, true });
-            enemy.lastShotTime = currentTime;       //for checking if the last shot was at least 5 seconds ago (reload time)
-        }
+    OcclusionJob& job = scene.job;
+    std::copy(glm::value_ptr(viewProjection), glm::value_ptr(viewProjection) + 16, job.viewProjection);
+    std::copy(eye, eye + 3, job.eye);
+    job.occluders = &wallMesh;
+    job.chunks.clear();
+    job.boxes.clear();
+
+    cullX.resize(enemies.size());
+    cullZ.resize(enemies.size());
+    visible.resize(std::max(enemies.size(), (size_t)bulletCount));
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        cullX[i] = enemies[i].x;
+        cullZ[i] = enemies[i].z;
     }
-}
+    const float enemyHalfSize[3] = { 0.71f, 0.5f, 0.71f };     //turned unit cube
+    int visibleEnemies = cullBoxes(frustum, cullX.data(), cullZ.data(), (int)enemies.size(), 0.5f, enemyHalfSize, visible.data());
+    visibleEnemies = cullHidden(visibleEnemies, 0.5f, enemyHalfSize);
+    for (int i = 0; i < visibleEnemies; ++i) {
+        const cube& enemy = enemies[visible[i]];
+        addCandidate(scene, glm::vec3(enemy.x, 0.5f, enemy.z), glm::radians(-enemy.rotation), glm::vec3(1.0f), enemyColor, enemyHalfSize);
+    }
+    scene.enemyCount = visibleEnemies;
 
-//---------------------------------------------------Methods to build structures---------------------------------------------------//
-void createCircularRoom(std::vector<wall>& levelPreset, int centerX, int centerZ, int radius, float maxHeight) {
-    //creates a circular room with holes on 4 sides to enter
-    for (int x = -radius; x <= radius; x++) {
-        for (int z = -radius; z <= radius; z++) {
-            if ((x * x + z * z <= radius * radius) &&
-                (x * x + z * z > (radius - 1) * (radius - 1)) &&  
-                !((z == radius || z == -radius) && x >= -1 && x <= 1) &&  
-                !((x == radius || x == -radius) && z >= -1 && z <= 1)) {  
-                wall w = { centerX + x, centerZ + z, maxHeight };
-                w.h = (std::rand() % 4 + 4);
-                levelPreset.push_back(w);
-            }
-        }
+    cullX.resize(bulletCount);
+    cullZ.resize(bulletCount);
+    for (int i = 0; i < bulletCount; ++i) {
+        cullX[i] = glm::mix(snapshot.bulletPrevX[i], snapshot.bulletX[i], alpha);
+        cullZ[i] = glm::mix(snapshot.bulletPrevZ[i], snapshot.bulletZ[i], alpha);
+    }
+    const float bulletHalfSize[3] = { 0.1f, 0.1f, 0.1f };
+    int visibleBullets = cullBoxes(frustum, cullX.data(), cullZ.data(), bulletCount, 0.5f, bulletHalfSize, visible.data());
+    visibleBullets = cullHidden(visibleBullets, 0.5f, bulletHalfSize);
+    for (int i = 0; i < visibleBullets; ++i) {
+        addCandidate(scene, glm::vec3(cullX[visible[i]], 0.5f, cullZ[visible[i]]), 0.0f, glm::vec3(0.2f), bulletColor, bulletHalfSize);
     }
-}
 
-void createSquareRoom(std::vector<wall>& levelPreset, int centerX, int centerZ, int roomSize, float maxHeight) {
-    //creates a square room with 4 entrances
-    for (int x = -roomSize / 2; x <= roomSize / 2; x++) {
-        for (int z = -roomSize / 2; z <= roomSize / 2; z++) {
-            if ((x == -roomSize / 2 || x == roomSize / 2 || z == -roomSize / 2 || z == roomSize / 2) &&
-                !((x >= -1 && x <= 1 && (z == -roomSize / 2 || z == roomSize / 2)) ||
-                    (z >= -1 && z <= 1 && (x == -roomSize / 2 || x == roomSize / 2)))) {
-                wall w = { centerX + x, centerZ + z, maxHeight };
-                w.h = (std::rand() % 4 + 4);
-                levelPreset.push_back(w);
-            }
+    //the walls of a room are also seen from outside of it
+    for (int i = 0; i < (int)wallChunks.size(); ++i) {
+        const WallChunk& chunk = wallChunks[i];
+        if (boxVisible(frustum, chunk.boxMin, chunk.boxMax) && boxVisibleInRoom(roomVisibility, chunk.region, chunk.region != 0, chunk.boxMin, chunk.boxMax)) {
+            job.chunks.push_back(i);
         }
     }
+
+    cullStats.roomsVisible = roomVisibility.roomsVisible;
+    cullStats.roomsTotal = (int)rooms.rooms.size();
+    submitOcclusionJob(occlusionWorker, job);
 }
 
-void createCross(std::vector<wall>& levelPreset, int centerX, int centerZ, int armLength, float maxHeight) {
-    //creates a cross with a thickness of on and a designated arm length
-    for (int x = 0; x <= 0; x++) {
-        for (int z = -armLength; z <= armLength; z++) {
-            wall w = { centerX + x, centerZ + z, maxHeight };
-            w.h = (std::rand() % 4 + 4);
-            levelPreset.push_back(w);
-        }
+//the same frame culled and drawn on the GPU, the CPU only uploads the instances
+void drawSceneGpuCulled(SceneFrame& scene) {
+    const float enemyHalfSize[3] = { 0.71f, 0.5f, 0.71f };
+    const float bulletHalfSize[3] = { 0.1f, 0.1f, 0.1f };
+    CullGroup groups[2];
+    groups[0].count = scene.enemyCount;
+    std::copy(enemyHalfSize, enemyHalfSize + 3, groups[0].halfSize);
+    groups[1].first = scene.enemyCount;
+    groups[1].count = (int)scene.candidates.size() - scene.enemyCount;
+    std::copy(bulletHalfSize, bulletHalfSize + 3, groups[1].halfSize);
+    {
+        PROFILE_GPU_SCOPE(gpuTimers, "gpuCulling");
+        runGpuCulling(gpuCulling, scene.frustum, scene.candidates.empty() ? nullptr : &scene.candidates[0].position.x, groups, 2);
     }
-
-    for (int z = 0; z <= 0; z++) {
-        for (int x = -armLength; x <= armLength; x++) {
-            if (true) {
-                wall w = { centerX + x, centerZ + z, maxHeight };
-                w.h = (std::rand() % 4 + 4);
-                levelPreset.push_back(w);
-            }
-        }
+    invalidateStateCache(renderQueue.state);
+
+    instances.clear();
+    InstanceBatch platformBatch = beginBatch();
+    addInstance(glm::vec3(0.0f), 0.0f, glm::vec3(1.0f), platformColor);
+    endBatch(platformBatch);
+    InstanceBatch playerBatch = beginBatch();
+    instances.push_back(scene.player);
+    endBatch(playerBatch);
+    InstanceBatch wallBatch = addWallMesh(0.0f);
+    uploadInstances();
+
+    submitInstances(shaderLit, meshPlatform, platformBatch, 0.0f);
+    submitInstances(shaderLit, meshCube, playerBatch, 0.0f);
+
+    //the command buffers were written by the compute shader, the CPU doesn't know what is in them
+    DrawPacket walls;
+    walls.key = makeSortKey(passOpaque, shaderLit, meshWalls, instancesOfFrame, 0.0f);
+    walls.kind = drawIndirect;
+    walls.program = sceneShader(shaderLit).id;
+    walls.vao = wallVAO;
+    walls.instanceBuffer = instanceVBO;
+    walls.firstInstance = wallBatch.first;
+    walls.indirectBuffer = gpuCulling.wallCommands;
+    walls.commandCount = gpuCulling.chunkCount;
+    if (walls.commandCount > 0) {
+        submitDraw(renderQueue, walls);
+    }
+    DrawPacket cubes = walls;
+    cubes.key = makeSortKey(passOpaque, shaderLit, meshCube, instancesGpuCulled, 0.0f);
+    cubes.vao = VAO[1];
+    cubes.instanceBuffer = gpuCulling.visibleInstances;
+    cubes.firstInstance = 0;
+    cubes.indirectBuffer = gpuCulling.cubeCommands;
+    cubes.commandCount = gpuCulling.groupCount;
+    if (cubes.commandCount > 0) {
+        submitDraw(renderQueue, cubes);
     }
+    submitOverlay(overlay, renderQueue);
+    PROFILE_GPU_SCOPE(gpuTimers, "drawScene");
+    flushQueue(renderQueue);
 }
 
-//---------------------------------------------------Methods that use the build methods to place structures and enemies---------------------------------------------------//
-std::vector<wall> generatelevel(float maxHeight, int level) {
-    std::vector<wall> levelPreset;
-    levelPreset.clear();
-
-    //the first level 
-    if (level == 1) {
-        //vectors that contain the x,z and size of the rooms {x, z, size}
-        std::vector<std::tuple<int, int, int>> squareRooms = {      
-            {-50, -50, 20}, {50, -50, 20}, {-50, 50, 20}, {50, 50, 20}, { 35, -15, 15}, { -20, 25, 12 }, { -40, -10, 18 },  { 30, 33, 8 }
-        };
-        std::vector<std::tuple<int, int, int>> roundRooms = {
-            {0, 0, 20}
-        };
-        std::vector<std::tuple<int, int, int>> cross = {
-            {0, 0, 10}
-        };
-        int roomSize = 20;
-        int crossLength = 10;
-
-        //creates the rooms
-        for (auto& pos : squareRooms) {
-            createSquareRoom(levelPreset, std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), maxHeight);
-        }
-
-        for (auto& pos : roundRooms) {
-            createCircularRoom(levelPreset, std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), maxHeight);
-        }
-        for (auto& pos : cross) {
-            createCross(levelPreset, std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), maxHeight);
-        }
-
-        int smallRoomSize = 20;
-        int roomCenterX = 0;
-        int roomCenterZ = -50;
-        //player spawn room
-        for (int x = -smallRoomSize / 2; x <= smallRoomSize / 2; x++) {
-            for (int z = -smallRoomSize / 2; z <= smallRoomSize / 2; z++) {
-                if ((x == -smallRoomSize / 2 || x == smallRoomSize / 2 || z == -smallRoomSize / 2 || z == smallRoomSize / 2) &&
-                    !(x >= -1 && x <= 1 && z == smallRoomSize / 2)) { 
-                    wall w = { roomCenterX + x, roomCenterZ + z, maxHeight };
-                    levelPreset.push_back(w);
-                }
-            }
-        }
+//Renders the frame prepareScene started, waits for the worker if it is not done yet
+void drawScene() {
+    PROFILE_SCOPE("drawScene");
+    SceneFrame& scene = sceneFrame;
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    beginQueue(renderQueue);
+    uploadUniformBlocks(scene.frame, scene.light);
+    if (scene.gpuCulled) {
+        drawSceneGpuCulled(scene);
+        return;
     }
-    //future levels would be added here
-    return levelPreset;
-}
-
-std::vector<cube> distributeEnemies(int level) {
-    std::vector<cube> enemies;
-    enemies.clear();
-    if (level == 1) {
-        std::vector<std::pair<float, float>> roomCenters = {        //contains the room coordinates
-            {-50, -50}, {50, -50}, {-50, 50}, {50, 50}, { 35, -15}, { -20, 25}, { -40, -10},  { 30, 33}  
-        };
-        //randomly places one or two enemies in each room
-        for (auto& center : roomCenters) {
-            int enemyCount = (std::rand() % 2) + 1;  
-            for (int i = 0; i < enemyCount; i++) {
-                float x = center.first + static_cast<float>((std::rand() % 8) - 4);
-                float z = center.second + static_cast<float>((std::rand() % 8) - 4);
-                cube enemy = { x, z, 0.0f, 0.05f, 0.0f };
-                enemies.push_back(enemy);
-            }
+    {
+        PROFILE_SCOPE("waitOcclusion");
+        waitOcclusionJob(occlusionWorker);
+    }
+    occlusionStats = scene.job.stats;
+
+    //one instanced draw per object type, the queue puts them in order
+    instances.clear();
+    InstanceBatch platformBatch = beginBatch();
+    addInstance(glm::vec3(0.0f), 0.0f, glm::vec3(1.0f), platformColor);
+    endBatch(platformBatch);
+
+    InstanceBatch playerBatch = beginBatch();
+    instances.push_back(scene.player);
+    endBatch(playerBatch);
+
+    InstanceBatch enemyBatch = beginBatch();
+    for (int i = 0; i < scene.enemyCount; ++i) {
+        if (scene.job.boxVisible[i]) {
+            instances.push_back(scene.candidates[i]);
         }
-
-        //enemies in the circular room are placed here
-        cube enemy = { 14, 12, 0.0f, 0.05f, 0.0f };
-        enemies.push_back(enemy);
-        enemy = { -10,-8, 0.0f, 0.05f, 0.0f };
-        enemies.push_back(enemy);
-        enemy = { -4,3, 0.0f, 0.05f, 0.0f };
-        enemies.push_back(enemy);
     }
-    return enemies;
-}
-
-std::vector<wall> setupGame(float platformSize, float maxHeight, int level) {
-    std::vector<wall> walls;
+    endBatch(enemyBatch);
 
-    walls = generatelevel(maxHeight, 1);
+    InstanceBatch wallBatch = addWallMesh(0.0f);
 
-    return walls;
+    InstanceBatch bulletBatch = beginBatch();
+    for (int i = scene.enemyCount; i < (int)scene.candidates.size(); ++i) {
+        if (scene.job.boxVisible[i]) {
+            instances.push_back(scene.candidates[i]);
+        }
+    }
+    endBatch(bulletBatch);
+
+    cullStats.enemiesVisible = enemyBatch.count;
+    cullStats.enemiesTotal = scene.enemiesTotal;
+    cullStats.bulletsVisible = bulletBatch.count;
+    cullStats.bulletsTotal = scene.bulletsTotal;
+
+    uploadInstances();
+    submitInstances(shaderLit, meshPlatform, platformBatch, 0.0f);
+    submitInstances(shaderLit, meshCube, playerBatch, nearestInstance(scene.eye, playerBatch));
+    submitInstances(shaderLit, meshCube, enemyBatch, nearestInstance(scene.eye, enemyBatch));
+    submitVisibleWalls(shaderLit, wallBatch, scene.job.chunks, scene.job.chunkVisible, scene.eye);
+    submitInstances(shaderLit, meshCube, bulletBatch, nearestInstance(scene.eye, bulletBatch));
+    submitOverlay(overlay, renderQueue);
+    PROFILE_GPU_SCOPE(gpuTimers, "drawScene");
+    flushQueue(renderQueue);
 }
 
 //---------------------------------------------------Loops for the pregame render---------------------------------------------------//
-void renderPreGameScene(cube player, const std::vector<wall>& walls, std::vector<bullet>& bullets) {
+void renderPreGameScene(cube player) {
     //almost the same as render scene only difference is no spotlight and no enemies are shown yet
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(shaderProgram);
-    glm::vec3 playerPosition(player.x, 0.0f, player.z);
+    beginQueue(renderQueue);
     glm::mat4 view = glm::lookAt(
         glm::vec3(40.0f * sin(glm::radians(cameraAngle)), 40.0f, 40.0f * cos(glm::radians(cameraAngle))),
         glm::vec3(0.0f, 0.0f, 0.0f),
@@ -601,56 +781,44 @@ void renderPreGameScene(cube player, const std::vector<wall>& walls, std::vector
     );
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
 
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-    glUniform1i(glGetUniformLocation(shaderProgram, "isPreGame"), GL_TRUE);
-
-    glm::vec3 ambientLightColor(1.0f, 1.0f, 1.0f);
-    float ambientIntensity = 0.3f;
-
-    glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(glm::vec3(0.0f, 10.0f, 0.0f)));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(glm::vec3(0.0f, 10.0f, 0.0f)));
-    glUniform1f(glGetUniformLocation(shaderProgram, "ambientStrength"), ambientIntensity);
-    glUniform1f(glGetUniformLocation(shaderProgram, "lightIntensity"), 0.6f);
-
-    //platform
-    glBindVertexArray(VAO[0]);
-    glm::mat4 model = glm::mat4(1.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), 0.24f, 0.39f, 0.18f, 1.0f);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-    //player
-    glBindVertexArray(VAO[1]);
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(player.x, 0.5f, player.z));
-    model = glm::rotate(model, glm::radians(-player.rotation), glm::vec3(0.0f, 1.0f, 0.0f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), 0.1f, 0.4f, 0.8f, 1.0f);
-    glUniform1f(glGetUniformLocation(shaderProgram, "playerDistance"), glm::length(playerPosition));
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-
-    //walls
-    for (const wall& w : walls) {
-        glm::vec3 wallPosition(w.x, (w.h / 2.0f) - rise, w.z);
-        model = glm::translate(glm::mat4(1.0f), wallPosition);
-        model = glm::scale(model, glm::vec3(1.0f, w.h, 1.0f));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), 0.54f, 0.27f, 0.07f, 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "playerDistance"), glm::length(playerPosition - wallPosition));
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    }
-
-    glUniform1i(glGetUniformLocation(shaderProgram, "isPreGame"), GL_FALSE);
-
+    FrameBlock frame;
+    frame.view = view;
+    frame.projection = projection;
+    frame.viewPos = glm::vec3(0.0f, 10.0f, 0.0f);
+    frame.fogDensity = 0.0f;
+
+    LightBlock light = {};
+    light.lightPos = glm::vec3(0.0f, 10.0f, 0.0f);
+    light.ambientStrength = 0.3f;
+    light.lightIntensity = 0.6f;
+    uploadUniformBlocks(frame, light);
+
+    //same instanced path as the game, the walls are still sunk into the ground by rise
+    instances.clear();
+    InstanceBatch platformBatch = beginBatch();
+    addInstance(glm::vec3(0.0f), 0.0f, glm::vec3(1.0f), platformColor);
+    endBatch(platformBatch);
+
+    InstanceBatch playerBatch = addTanks(&player, 1, playerColor);
+    InstanceBatch wallBatch = addWallMesh(-rise);
+
+    uploadInstances();
+    submitInstances(0, meshPlatform, platformBatch, 0.0f);
+    submitInstances(0, meshCube, playerBatch, 0.0f);
+    submitInstances(0, meshWalls, wallBatch, 0.0f);
+    flushQueue(renderQueue);
 }
 
-void gameStart(GLFWwindow* window, cube player, std::vector<bullet>& bullets, std::vector<cube> enemies, const std::vector<wall>& walls) {
+void gameStart(GLFWwindow* window, const GameState& game) {
     //method that runs during the pre game map showcase (the spinning map overview in the beginning)
+    double lastTime = glfwGetTime();
     while (!glfwWindowShouldClose(window)) {
-        if (cameraAngle < 360.1f) { cameraAngle = cameraAngle + 0.1f; }
-        if (rise > 0) { rise = rise - 0.005f; }
-        renderPreGameScene(player, walls, bullets);
+        double now = glfwGetTime();
+        float frameTime = (float)(now - lastTime);
+        lastTime = now;
+        if (cameraAngle < 360.1f) { cameraAngle = cameraAngle + 6.0f * frameTime; }   //6 degrees per second
+        if (rise > 0) { rise = rise - 0.3f * frameTime; }
+        renderPreGameScene(game.player);
         glfwSwapBuffers(window);
         glfwPollEvents();
         if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS) {
@@ -663,25 +831,219 @@ void gameStart(GLFWwindow* window, cube player, std::vector<bullet>& bullets, st
     }
 }
 
+//---------------------------------------------------Profiler---------------------------------------------------//
+//Built with TANKS_PROFILE the frame is timed in scopes, see profiler.hpp. P writes the last events as a Chrome trace,
+//and with --profile-frames N it is written once after N frames of the game.
+const char* traceFile = "tanks_trace.json";
+int profileFrames = 0;                              //0 only writes on P
+int framesProfiled = 0;
+
+void writeTrace() {
+#ifdef TANKS_PROFILE
+    int64_t events = std::min(profileEventsRecorded(), (int64_t)profileRingSize);
+    if (writeChromeTrace(traceFile)) {
+        std::cout << "Profile of the last " << events << " events written to " << traceFile << ", " << gpuTimers.dropped << " GPU timings were not ready in time" << std::endl;
+    }
+    else {
+        std::cerr << "Could not write " << traceFile << std::endl;
+    }
+#else
+    std::cout << "The profiler is not built in, configure with TANKS_PROFILE=ON" << std::endl;
+#endif
+}
+
+//---------------------------------------------------Overlay---------------------------------------------------//
+//Live stats in the top left corner, H hides them. The first font file that loads is used, without one
+//(or built without FreeType) the overlay falls back to its 8x8 font.
+const std::vector<const char*> overlayFonts = {
+    "hud.ttf",                                      //next to the game, any monospaced font
+    "C:/Windows/Fonts/consola.ttf",
+    "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+    "/System/Library/Fonts/Menlo.ttc",
+};
+
+//frame time, counts and cooldowns of the snapshot, culling and the render queue of the last frame, the input latency
+//of the last second and the overlay itself. The only place the game shows these while it runs
+void addStatsOverlay(const GameSnapshot& snapshot, double frameSeconds, const InputLatency& latency, int ticksDropped) {
+    PROFILE_SCOPE("statsOverlay");
+    const uint32_t panelColor = overlayColor(0.0f, 0.0f, 0.0f, 0.6f);
+    const uint32_t textColor = overlayColor(0.9f, 0.9f, 0.9f, 1.0f);
+    const uint32_t readyColor = overlayColor(0.3f, 0.9f, 0.3f, 1.0f);
+    const uint32_t reloadColor = overlayColor(0.9f, 0.6f, 0.2f, 1.0f);
+    const RenderStats& render = renderQueue.stats;
+    const cube& player = snapshot.player;
+
+    int enemiesReady = 0;
+    for (const cube& enemy : snapshot.enemies) {
+        enemiesReady += snapshot.time - enemy.lastShotTime > enemy.shootCooldown;
+    }
+    float reloadLeft = std::max(0.0f, player.shootCooldown - (float)(snapshot.time - player.lastShotTime));
+
+    const int lineCount = 8;
+    char lines[lineCount][128];
+    snprintf(lines[0], sizeof(lines[0]), "%.0f fps  %.2f ms", 1.0 / frameSeconds, frameSeconds * 1000.0);
+    if (sceneFrame.gpuCulled) {
+        snprintf(lines[1], sizeof(lines[1]), "enemies %d  bullets %d  (culled on the GPU)", (int)snapshot.enemies.size(), (int)snapshot.bulletX.size());
+    }
+    else {
+        snprintf(lines[1], sizeof(lines[1]), "enemies %d  bullets %d  visible %d/%d", (int)snapshot.enemies.size(), (int)snapshot.bulletX.size(),
+                 cullStats.enemiesVisible + cullStats.bulletsVisible, cullStats.enemiesTotal + cullStats.bulletsTotal);
+    }
+    snprintf(lines[2], sizeof(lines[2]), "reload");
+    snprintf(lines[3], sizeof(lines[3]), "enemies reloaded %d/%d", enemiesReady, (int)snapshot.enemies.size());
+    snprintf(lines[4], sizeof(lines[4]), "draws %d  state changes skipped %d/%d  overlay %d quads %.1f us", render.drawCalls,
+             skippedStateChanges(render), totalStateChanges(render), overlay.stats.quads, overlay.stats.microseconds);
+    if (sceneFrame.gpuCulled) {
+        snprintf(lines[5], sizeof(lines[5]), "wall chunks %d  tested on the GPU", gpuCulling.chunkCount);
+    }
+    else {
+        snprintf(lines[5], sizeof(lines[5]), "rooms %d/%d  wall chunks %d/%d  occluded %d/%d chunks %d/%d boxes  %.2f ms", cullStats.roomsVisible, cullStats.roomsTotal,
+                 cullStats.chunksVisible, cullStats.chunksTotal, occlusionStats.chunksOccluded, occlusionStats.chunksTested, occlusionStats.boxesOccluded,
+                 occlusionStats.boxesTested, occlusionStats.milliseconds);
+    }
+    //the simulation thread pipelines the updates behind the drawing, that costs at least one frame of latency
+    double latencySeconds = latency.samples > 0 ? latency.total / latency.samples : 0.0;
+    snprintf(lines[6], sizeof(lines[6]), "input latency %.1f ms = %.1f frames, pipelined  worst %.1f ms  %d updates dropped", latencySeconds * 1000.0,
+             latencySeconds / frameSeconds, latency.worst * 1000.0, ticksDropped);
+    const AiStats& ai = snapshot.ai;
+    snprintf(lines[7], sizeof(lines[7]), "ai %d thinks  %d sight tests  %.0f us  stale %.1f  over budget %d/%d", ai.thinks, ai.lineOfSightTests,
+             ai.microseconds, ai.updates > 0 ? ai.stalenessSum / ai.updates : 0.0, ai.overruns, ai.updates);
+    char reloadText[32];
+    snprintf(reloadText, sizeof(reloadText), reloadLeft > 0.0f ? "%.1f s" : "ready", reloadLeft);
+
+    //the reload line is a bar between its label and the seconds
+    const GlyphAtlas& atlas = overlay.atlas;
+    float line = overlayLineHeight(atlas);
+    float margin = std::round(0.5f * line);
+    float labelWidth, barWidth = 8.0f * line, reloadWidth, height;
+    measureText(atlas, "reload ", labelWidth, height);
+    measureText(atlas, reloadText, reloadWidth, height);
+    float panelWidth = labelWidth + barWidth + margin + reloadWidth;
+    for (int i = 0; i < lineCount; ++i) {
+        float width;
+        measureText(atlas, lines[i], width, height);
+        panelWidth = std::max(panelWidth, width);
+    }
+
+    float x = 2.0f * margin, y = 2.0f * margin;
+    addRect(overlay, x - margin, y - margin, panelWidth + 2.0f * margin, lineCount * line + 2.0f * margin, panelColor);
+    for (int i = 0; i < lineCount; ++i) {
+        addText(overlay, x, y + i * line, lines[i], textColor);
+    }
+    float barX = x + labelWidth, barY = y + 2.0f * line + 0.2f * line, barHeight = 0.6f * line;
+    float loaded = player.shootCooldown > 0.0f ? 1.0f - reloadLeft / player.shootCooldown : 1.0f;
+    uint32_t barColor = reloadLeft > 0.0f ? reloadColor : readyColor;
+    addRect(overlay, barX, barY, barWidth, barHeight, overlayColor(1.0f, 1.0f, 1.0f, 0.15f));
+    addRect(overlay, barX, barY, barWidth * loaded, barHeight, barColor);
+    addText(overlay, barX + barWidth + margin, y + 2.0f * line, reloadText, barColor);
+}
+
 //---------------------------------------------------Main, Game loop---------------------------------------------------//
-void gameloop(GLFWwindow* window, cube player, std::vector<bullet>& bullets, std::vector<cube> enemies, const std::vector<wall>& walls) {
-    while (!glfwWindowShouldClose(window) && !enemies.empty()) {
-        float currentTime = glfwGetTime();
-        processInput(window, player, bullets, currentTime);
-        updateBullets(bullets, walls, platformSize, enemies, player, 0.2f);
-        renderScene(player, walls, bullets, enemies);
-        checkPlayerCollision(player, walls);
-        enemyShootAtPlayer(enemies, player, bullets, walls, currentTime);
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-        if (!isPlayerAlive) {
-            std::cout << "Player has been defeated!" << std::endl;
+//The simulation runs on its own thread in fixed steps and publishes a snapshot after each (see simthread.hpp).
+//This loop only reads input and draws the newest snapshot, blended by the time since it was published,
+//so the updates of the next frame run while this one is drawn and swapped.
+void gameloop(GLFWwindow* window, GameState& game) {
+    const double tickLength = 1.0 / tickRate;
+    double lastReport = glfwGetTime();
+    bool gpuKeyDown = false;                        //G toggles the GPU culling once per press
+    bool traceKeyDown = false;
+    bool overlayKeyDown = false;                    //H shows and hides the stats
+    bool showOverlay = true;
+    double lastFrame = lastReport;
+    double frameSeconds = tickLength;               //smoothed over the last few frames for the overlay
+    InputLatency latencyShown;                      //the last full second, what the overlay shows
+    game.time = lastReport;
+
+    SimThread sim;
+    sim.maxCatchUp = maxFrameTime;
+    InputLatency latency;
+    uint32_t inputBits = packInput(TickInput());
+    uint32_t inputSequence = 0;
+    sendInput(sim, TickInput(), inputSequence);
+    //game belongs to the simulation thread now, the rooms are only read here and never change after startGame
+    startSimThread(sim, game);
+
+    while (!glfwWindowShouldClose(window)) {
+        PROFILE_SCOPE("frame");
+        PROFILE_GPU_FRAME(gpuTimers);
+        double frameStart = glfwGetTime();
+        frameSeconds += 0.1 * (frameStart - lastFrame - frameSeconds);
+        lastFrame = frameStart;
+        //the occlusion test of the newest snapshot runs on the worker while input is read
+        takeLatest(sim.snapshots);
+        const GameSnapshot& snapshot = readSlot(sim.snapshots);
+        float alpha = (float)glm::clamp((simThreadClock() - snapshot.publishedAt) / tickLength, 0.0, 1.0);
+        prepareScene(snapshot, game.rooms, alpha);
+
+        TickInput input;
+        {
+            PROFILE_SCOPE("input");
+            glfwPollEvents();
+            input = readInput(window);
+        }
+        if (packInput(input) != inputBits) {
+            inputBits = packInput(input);
+            inputSequence = inputChanged(latency, simThreadClock());
+        }
+        sendInput(sim, input, inputSequence);
+        bool gpuKey = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+        if (gpuKey && !gpuKeyDown && gpuCulling.supported) {
+            useGpuCulling = !useGpuCulling;
+            std::cout << "Culling on the " << (useGpuCulling ? "GPU" : "CPU") << std::endl;
+        }
+        gpuKeyDown = gpuKey;
+        bool traceKey = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+        ++framesProfiled;
+        if ((traceKey && !traceKeyDown) || framesProfiled == profileFrames) {
+            writeTrace();
+        }
+        traceKeyDown = traceKey;
+        bool overlayKey = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+        if (overlayKey && !overlayKeyDown) {
+            showOverlay = !showOverlay;
+        }
+        overlayKeyDown = overlayKey;
+
+        //drawScene puts it into the same queue, the render stats it shows are still the last frame's
+        beginOverlay(overlay);
+        if (showOverlay) {
+            addStatsOverlay(snapshot, frameSeconds, latencyShown, sim.ticksDropped);
+        }
+        endOverlay(overlay);
+        drawScene();
+        {
+            PROFILE_SCOPE("swap");
+            glfwSwapBuffers(window);
+        }
+        framePresented(latency, snapshot, simThreadClock());
+
+        //from polling a changed key to the end of the swap that shows the first update with it, shown per second
+        double now = glfwGetTime();
+        if (now - lastReport >= 1.0) {
+            lastReport = now;
+            latencyShown = latency;
+            latency.samples = 0;
+            latency.total = latency.worst = 0.0;
+        }
+        if (snapshot.isGameOver) {
+            if (!snapshot.isPlayerAlive) {
+                std::cout << "Player has been defeated!" << std::endl;
+            }
             break;
         }
     }
+    stopSimThread(sim);
 }
 
-int main() {
+//usage: playground [--profile-frames N]
+int main(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--profile-frames") == 0) {
+            profileFrames = std::atoi(argv[i + 1]);
+        }
+    }
+    PROFILE_THREAD("main");
+
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
@@ -700,30 +1062,59 @@ int main() {
         return -1;
     }
 
-    shaderProgram = LoadShaders("SimpleVertexShader.vertexshader", "SimpleFragmentShader.fragmentshader");
+    //linked programs are kept as driver binaries, the second start skips compiling and linking
+    SetShaderCacheDirectory("shadercache");
+    sceneShaders.vertex_file_path = "SimpleVertexShader.vertexshader";
+    sceneShaders.fragment_file_path = "SimpleFragmentShader.fragmentshader";
+    sceneShaders.features = { "LIT", "FOG" };
+    setupUniformBlocks();
+    //both variants the game uses are built now, so the switch after the pregame doesn't hitch
+    sceneShader(0);
+    sceneShader(shaderLit);
     glEnable(GL_DEPTH_TEST);
 
-    setupPlatformAndCube();
-    cube player = { 0.0f, -50.0f, 180.0f, 0.1f, 0.0f };
-    //these methods should be placed in the while loop if there were more levels
-    std::vector<cube> enemies = distributeEnemies(1);
-    std::vector<wall> walls = setupGame(platformSize, maxHeight, 1);
-    std::vector<bullet> bullets;
+    GameState level1;
+    startGame(level1, level, levelSeed, glfwGetTime());
+    level1.ai.budgetMicroseconds = aiBudgetMicroseconds;
+    setupPlatformAndCube(level1.platformSize);
+    setupWallMesh(level1.walls, level1.rooms);
+    startOcclusionWorker(occlusionWorker);
+    setupGpuCulling(gpuCulling, wallChunks, sizeof(CubeInstance) / sizeof(float));
+    renderQueue.pointInstances = pointInstanceAttributes;
+#ifdef TANKS_PROFILE
+    setupGpuTimers(gpuTimers);
+#endif
+    setupOverlay(overlay, overlayFonts, HEIGHT / 60, WIDTH, HEIGHT);
+    ShaderCacheStats shaderStats = GetShaderCacheStats();
+    std::cout << "Shaders ready in " << shaderStats.seconds * 1000.0 << " ms (" << shaderStats.hits << " from the cache, "
+              << shaderStats.compiled << " compiled, " << shaderStats.rejected << " rejected)" << std::endl;
 
     while (level == 1 && !glfwWindowShouldClose(window)) {
-        isPlayerAlive = true;
-        glUniform1i(glGetUniformLocation(shaderProgram, "isPreGame"), GL_TRUE);
-        gameStart(window, player, bullets, enemies, walls);
+        //every attempt starts from the same level
+        GameState game = level1;
+        gameStart(window, game);
 
         cameraAngle = 0.0f;
-        glUniform1i(glGetUniformLocation(shaderProgram, "isPreGame"), GL_FALSE);
-        gameloop(window, player, bullets, enemies, walls);
+        gameloop(window, game);
     }
 
 
+    stopOcclusionWorker(occlusionWorker);
+    deleteGpuCulling(gpuCulling);
+    deleteOverlay(overlay);
+#ifdef TANKS_PROFILE
+    deleteGpuTimers(gpuTimers);
+#endif
     glDeleteVertexArrays(2, VAO);
     glDeleteBuffers(2, VBO);
     glDeleteBuffers(2, EBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteVertexArrays(1, &wallVAO);
+    glDeleteBuffers(1, &wallVBO);
+    glDeleteBuffers(1, &wallEBO);
+    glDeleteBuffers(1, &frameUBO);
+    glDeleteBuffers(1, &lightUBO);
+    DeleteShaderVariants(sceneShaders);
     glfwTerminate();
     return 0;
-}
\ No newline at end of file
+}
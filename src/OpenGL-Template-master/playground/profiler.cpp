@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "profiler.hpp"
+
+//without TANKS_PROFILE nothing is built, not even the ring
+#ifdef TANKS_PROFILE
+
+static ProfileSlot ring[profileRingSize];
+static std::atomic<uint64_t> ringHead{ 0 };        //index of the next event, only grows
+
+static const char* trackNames[maxProfileTracks];
+static std::atomic<int> trackCount{ 0 };
+
+static thread_local int threadTrack = -1;
+static thread_local int threadDepth = 0;
+
+int64_t profileClock() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int profileTrack(const char* name) {
+    int track = trackCount.fetch_add(1);
+    if (track >= maxProfileTracks) {
+        trackCount = maxProfileTracks;
+        return -1;
+    }
+    trackNames[track] = name;
+    return track;
+}
+
+int currentProfileTrack() {
+    if (threadTrack < 0) {
+        threadTrack = profileTrack("thread");
+    }
+    return threadTrack;
+}
+
+void setProfileThreadName(const char* name) {
+    if (threadTrack < 0) {
+        threadTrack = profileTrack(name);
+    }
+    else {
+        trackNames[threadTrack] = name;
+    }
+}
+
+//every writer claims its own slot, the sequence tells a reader whether the slot holds a finished event and which one
+void recordProfileEvent(const char* name, int track, int64_t start, int64_t duration, int depth) {
+    if (track < 0) {
+        return;
+    }
+    uint64_t index = ringHead.fetch_add(1, std::memory_order_relaxed);
+    ProfileSlot& slot = ring[index % profileRingSize];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = { name, start, duration, track, depth };
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+int64_t profileEventsRecorded() {
+    return (int64_t)ringHead.load(std::memory_order_relaxed);
+}
+
+ProfileScope::ProfileScope(const char* scopeName) : name(scopeName), start(profileClock()) {
+    threadDepth++;
+}
+
+ProfileScope::~ProfileScope() {
+    threadDepth--;
+    recordProfileEvent(name, currentProfileTrack(), start, profileClock() - start, threadDepth);
+}
+
+//the names are string literals of this program, only quotes and backslashes need escaping
+static void writeJsonString(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool writeChromeTrace(const char* path) {
+    //copy what is in the ring now, slots that are being written or were overwritten while copying are left out
+    uint64_t end = ringHead.load(std::memory_order_acquire);
+    uint64_t begin = end > (uint64_t)profileRingSize ? end - profileRingSize : 0;
+    std::vector<ProfileEvent> events;
+    events.reserve((size_t)(end - begin));
+    for (uint64_t index = begin; index < end; ++index) {
+        ProfileSlot& slot = ring[index % profileRingSize];
+        if (slot.sequence.load(std::memory_order_acquire) != 2 * index + 2) {
+            continue;
+        }
+        ProfileEvent event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == 2 * index + 2) {
+            events.push_back(event);
+        }
+    }
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    const char* separator = "";
+    int tracks = std::min(trackCount.load(), maxProfileTracks);
+    for (int track = 0; track < tracks; ++track) {
+        fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", separator, track);
+        writeJsonString(file, trackNames[track] ? trackNames[track] : "thread");
+        fprintf(file, "}},\n{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}", track, track);
+        separator = ",\n";
+    }
+    //complete events, microseconds with the nanoseconds kept as fraction
+    for (const ProfileEvent& event : events) {
+        fprintf(file, "%s{\"ph\":\"X\",\"name\":", separator);
+        writeJsonString(file, event.name);
+        fprintf(file, ",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%d}}", event.track, event.start / 1000.0, event.duration / 1000.0, event.depth);
+        separator = ",\n";
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+//Frame profiler: scopes on any thread write one event each into a lock free ring, writeChromeTrace turns the ring
+//into a trace for chrome://tracing or ui.perfetto.dev. GPU times from gputimers.hpp go into the same ring on their own track.
+//Everything is only built with TANKS_PROFILE defined (CMake option TANKS_PROFILE), without it the macros are empty.
+
+const int profileRingSize = 1 << 16;                //events kept, older ones are overwritten
+const int maxProfileTracks = 16;                    //threads plus the GPU
+
+//one finished scope
+struct ProfileEvent {
+    const char* name;                               //must stay valid until the trace is written, string literals
+    int64_t start;                                  //nanoseconds of profileClock
+    int64_t duration;
+    int track;
+    int depth;                                      //scopes open around it on the same thread
+};
+
+struct ProfileSlot {
+    std::atomic<uint64_t> sequence{ 0 };            //2 * index + 1 while it is written, 2 * index + 2 when done
+    ProfileEvent event;
+};
+
+int64_t profileClock(); //<<< nanoseconds on a steady clock
+int profileTrack(const char* name); //<<< a new track, e.g. for the GPU, -1 when all are taken
+void setProfileThreadName(const char* name); //<<< the calling thread's track is named like this
+int currentProfileTrack(); //<<< track of the calling thread, made on first use
+void recordProfileEvent(const char* name, int track, int64_t start, int64_t duration, int depth); //<<< lock free, from any thread
+bool writeChromeTrace(const char* path); //<<< the events in the ring as trace JSON, false if the file can't be written
+int64_t profileEventsRecorded(); //<<< since the start, including the overwritten ones
+
+//measures from construction to the end of the block
+struct ProfileScope {
+    const char* name;
+    int64_t start;
+    explicit ProfileScope(const char* scopeName);
+    ~ProfileScope();
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+#ifdef TANKS_PROFILE
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) setProfileThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstring>
+
+#include "renderqueue.hpp"
+
+uint64_t makeSortKey(int pass, int program, int mesh, int material, float depth) {
+    depth = std::max(depth, 0.0f);                  //also turns -0 into +0
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    return ((uint64_t)(pass & 0xF) << 60) | ((uint64_t)(program & 0xFF) << 52) | ((uint64_t)(mesh & 0xFF) << 44) |
+           ((uint64_t)(material & 0xFFF) << 32) | depthBits;
+}
+
+void beginQueue(RenderQueue& queue) {
+    queue.packets.clear();
+    queue.rangeCounts.clear();
+    queue.rangeOffsets.clear();
+    queue.stats = RenderStats();
+}
+
+int addRange(RenderQueue& queue, GLsizei indexCount, int firstIndex) {
+    queue.rangeCounts.push_back(indexCount);
+    queue.rangeOffsets.push_back((const void*)(firstIndex * sizeof(unsigned int)));
+    return (int)queue.rangeCounts.size() - 1;
+}
+
+void submitDraw(RenderQueue& queue, const DrawPacket& packet) {
+    queue.packets.push_back(packet);
+}
+
+void invalidateStateCache(StateCache& state) {
+    state.valid = false;
+}
+
+//the GL state is unknown at the start and after invalidateStateCache, everything is bound once then
+static void validate(StateCache& state) {
+    if (state.valid) {
+        return;
+    }
+    state.program = 0;
+    state.vao = 0;
+    state.arrayBuffer = 0;
+    state.indirectBuffer = 0;
+    state.texture = 0;
+    state.pass = -1;
+    glUseProgram(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    state.valid = true;
+}
+
+static void useProgram(RenderQueue& queue, GLuint program) {
+    if (queue.state.program == program) {
+        queue.stats.programBindsSkipped++;
+        return;
+    }
+    glUseProgram(program);
+    queue.state.program = program;
+    queue.stats.programBinds++;
+}
+
+static void bindVertexArray(RenderQueue& queue, GLuint vao) {
+    if (queue.state.vao == vao) {
+        queue.stats.vaoBindsSkipped++;
+        return;
+    }
+    glBindVertexArray(vao);
+    queue.state.vao = vao;
+    queue.stats.vaoBinds++;
+}
+
+void bindArrayBuffer(RenderQueue& queue, GLuint buffer) {
+    validate(queue.state);
+    if (queue.state.arrayBuffer == buffer) {
+        queue.stats.bufferBindsSkipped++;
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    queue.state.arrayBuffer = buffer;
+    queue.stats.bufferBinds++;
+}
+
+//the pointers are state of the vao, they stay valid when the buffer gets new storage every frame
+static void pointInstances(RenderQueue& queue, GLuint vao, GLuint buffer, int firstInstance) {
+    std::vector<StateCache::InstanceSource>& sources = queue.state.instanceSources;
+    auto source = std::find_if(sources.begin(), sources.end(), [vao](const StateCache::InstanceSource& s) { return s.vao == vao; });
+    if (source != sources.end() && source->buffer == buffer && source->firstInstance == firstInstance) {
+        queue.stats.instancePointersSkipped++;
+        return;
+    }
+    queue.pointInstances(buffer, firstInstance);
+    queue.state.arrayBuffer = buffer;
+    queue.stats.instancePointers++;
+    if (source == sources.end()) {
+        sources.push_back({ vao, buffer, firstInstance });
+    }
+    else {
+        source->buffer = buffer;
+        source->firstInstance = firstInstance;
+    }
+}
+
+static void bindIndirectBuffer(RenderQueue& queue, GLuint buffer) {
+    if (queue.state.indirectBuffer == buffer) {
+        queue.stats.bufferBindsSkipped++;
+        return;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    queue.state.indirectBuffer = buffer;
+    queue.stats.bufferBinds++;
+}
+
+static void bindTexture(RenderQueue& queue, GLuint texture) {
+    if (queue.state.texture == texture) {
+        queue.stats.textureBindsSkipped++;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    queue.state.texture = texture;
+    queue.stats.textureBinds++;
+}
+
+//opaque packets write and test depth, the overlay is blended over whatever is there
+static void setPass(RenderQueue& queue, int pass) {
+    if (queue.state.pass == pass) {
+        return;
+    }
+    if (pass == passOverlay) {
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    else {
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+    }
+    queue.state.pass = pass;
+}
+
+void uploadUniformBlock(RenderQueue& queue, GLuint buffer, const void* data, int size) {
+    std::vector<StateCache::BlockContents>& blocks = queue.state.blocks;
+    auto block = std::find_if(blocks.begin(), blocks.end(), [buffer](const StateCache::BlockContents& b) { return b.buffer == buffer; });
+    if (block == blocks.end()) {
+        blocks.push_back({ buffer, std::vector<char>() });
+        block = blocks.end() - 1;
+    }
+    else if ((int)block->bytes.size() == size && std::memcmp(block->bytes.data(), data, size) == 0) {
+        queue.stats.blockUploadsSkipped++;
+        return;
+    }
+    block->bytes.assign((const char*)data, (const char*)data + size);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    queue.stats.blockUploads++;
+}
+
+void flushQueue(RenderQueue& queue) {
+    validate(queue.state);
+    //stable, so packets with the same key are drawn in the order they were submitted
+    std::stable_sort(queue.packets.begin(), queue.packets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+
+    for (const DrawPacket& packet : queue.packets) {
+        queue.stats.packets++;
+        setPass(queue, (int)(packet.key >> 60));
+        useProgram(queue, packet.program);
+        bindVertexArray(queue, packet.vao);
+        if (packet.instanceBuffer != 0) {
+            pointInstances(queue, packet.vao, packet.instanceBuffer, packet.firstInstance);
+        }
+        if (packet.texture != 0) {
+            bindTexture(queue, packet.texture);
+        }
+        switch (packet.kind) {
+        case drawInstanced:
+            glDrawElementsInstanced(GL_TRIANGLES, packet.indexCount, GL_UNSIGNED_INT, 0, packet.instanceCount);
+            break;
+        case drawRanges:
+            glMultiDrawElements(GL_TRIANGLES, &queue.rangeCounts[packet.firstRange], GL_UNSIGNED_INT, &queue.rangeOffsets[packet.firstRange], packet.rangeCount);
+            break;
+        case drawIndirect:
+            bindIndirectBuffer(queue, packet.indirectBuffer);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, packet.commandCount, 0);
+            break;
+        case drawArrays:
+            glDrawArrays(GL_TRIANGLES, packet.firstVertex, packet.vertexCount);
+            break;
+        }
+        queue.stats.drawCalls++;
+    }
+    //code outside the queue expects the depth test of the scene
+    setPass(queue, passOpaque);
+    queue.packets.clear();
+}
+
+int skippedStateChanges(const RenderStats& stats) {
+    return stats.programBindsSkipped + stats.vaoBindsSkipped + stats.bufferBindsSkipped + stats.textureBindsSkipped + stats.instancePointersSkipped + stats.blockUploadsSkipped;
+}
+
+int totalStateChanges(const RenderStats& stats) {
+    return skippedStateChanges(stats) + stats.programBinds + stats.vaoBinds + stats.bufferBinds + stats.textureBinds + stats.instancePointers + stats.blockUploads;
+}
@@ -0,0 +1,101 @@
+#ifndef RENDERQUEUE_HPP
+#define RENDERQUEUE_HPP
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+//Draws are not issued where they are decided: the passes submit packets, flushQueue sorts them by their key
+//and replays them through a cache of the GL state, so binds and uploads that would not change anything are skipped.
+
+//Sort key, most significant first. The slots are small numbers chosen by the caller, not GL names,
+//so the order between programs and meshes is decided by the caller too.
+//  63..60 pass, 59..52 program, 51..44 mesh (vao), 43..32 material, 31..0 depth
+//The depth is the bit pattern of a non negative float distance, those sort like the floats themselves,
+//so inside one state opaque packets come front to back and early depth testing drops more fragments.
+enum RenderPass {
+    passOpaque = 0,
+    passOverlay = 1,                                //drawn after the scene, on top of it, blended and without depth test
+};
+
+uint64_t makeSortKey(int pass, int program, int mesh, int material, float depth); //<<< depth is clamped to 0 and up
+
+//which draw call a packet ends in
+enum DrawKind {
+    drawInstanced,                                  //glDrawElementsInstanced, indexCount indices for instanceCount instances
+    drawRanges,                                     //glMultiDrawElements over rangeCount of the queue's ranges, one instance
+    drawIndirect,                                   //glMultiDrawElementsIndirect, commandCount commands from indirectBuffer
+    drawArrays,                                     //glDrawArrays, vertexCount vertices starting at firstVertex, no index buffer
+};
+
+struct DrawPacket {
+    uint64_t key = 0;
+    DrawKind kind = drawInstanced;
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint instanceBuffer = 0;                      //the instance attributes (2-4) of the vao read from here,
+    int firstInstance = 0;                          //starting with this instance
+    GLsizei indexCount = 0;
+    GLsizei instanceCount = 0;
+    int firstRange = 0, rangeCount = 0;             //drawRanges
+    GLuint indirectBuffer = 0;                      //drawIndirect
+    GLsizei commandCount = 0;
+    GLint firstVertex = 0;                          //drawArrays
+    GLsizei vertexCount = 0;
+    GLuint texture = 0;                             //GL_TEXTURE_2D of unit 0, left as it is if 0
+};
+
+//What was bound last. Code that binds programs or buffers outside the queue has to call invalidateStateCache afterwards,
+//the instance attributes of the vaos must only be pointed through the queue.
+struct StateCache {
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint arrayBuffer = 0;
+    GLuint indirectBuffer = 0;
+    GLuint texture = 0;
+    int pass = -1;                                  //whose depth and blend state is set, -1 unknown
+    struct InstanceSource {
+        GLuint vao, buffer;
+        int firstInstance;
+    };
+    std::vector<InstanceSource> instanceSources;    //where each vao's instance attributes point, kept across frames
+    struct BlockContents {
+        GLuint buffer;
+        std::vector<char> bytes;
+    };
+    std::vector<BlockContents> blocks;              //last upload of every uniform buffer
+    bool valid = false;
+};
+
+//state changes of the last frame, made and skipped because they were already set
+struct RenderStats {
+    int packets = 0, drawCalls = 0;
+    int programBinds = 0, programBindsSkipped = 0;
+    int vaoBinds = 0, vaoBindsSkipped = 0;
+    int bufferBinds = 0, bufferBindsSkipped = 0;
+    int textureBinds = 0, textureBindsSkipped = 0;
+    int instancePointers = 0, instancePointersSkipped = 0;
+    int blockUploads = 0, blockUploadsSkipped = 0;
+};
+
+struct RenderQueue {
+    void (*pointInstances)(GLuint buffer, int firstInstance) = nullptr;  //points the bound vao's instance attributes, also binds buffer to GL_ARRAY_BUFFER
+    std::vector<DrawPacket> packets;
+    std::vector<GLsizei> rangeCounts;               //index count and byte offset of every range for drawRanges
+    std::vector<const void*> rangeOffsets;
+    StateCache state;
+    RenderStats stats;
+};
+
+void beginQueue(RenderQueue& queue); //<<< drops last frame's packets and clears the counters
+int addRange(RenderQueue& queue, GLsizei indexCount, int firstIndex); //<<< returns the index of the range for DrawPacket::firstRange
+void submitDraw(RenderQueue& queue, const DrawPacket& packet);
+void flushQueue(RenderQueue& queue); //<<< sorts and draws everything submitted since beginQueue
+
+void invalidateStateCache(StateCache& state); //<<< the next packet binds everything again
+void bindArrayBuffer(RenderQueue& queue, GLuint buffer); //<<< GL_ARRAY_BUFFER through the cache, for uploads between draws
+void uploadUniformBlock(RenderQueue& queue, GLuint buffer, const void* data, int size); //<<< skipped if the buffer already holds these bytes
+int skippedStateChanges(const RenderStats& stats);
+int totalStateChanges(const RenderStats& stats); //<<< made plus skipped
+
+#endif
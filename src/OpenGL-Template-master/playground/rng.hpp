@@ -0,0 +1,31 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstdint>
+
+//SplitMix64: the state is a plain counter and every number is a hash of it. Only integer math,
+//so a seed gives the same numbers on every platform and compiler, unlike std::rand.
+//Each match carries its own, so levels can be generated on any thread.
+struct Rng {
+    uint64_t state = 0;
+};
+
+inline Rng seedRng(uint64_t seed) {
+    Rng rng;
+    rng.state = seed;
+    return rng;
+}
+
+inline uint64_t nextRandom(Rng& rng) {
+    uint64_t z = (rng.state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+//uniform int in [0, n), takes the high bits so small n don't only see the low ones
+inline int randomInt(Rng& rng, int n) {
+    return (int)(((nextRandom(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
+#endif
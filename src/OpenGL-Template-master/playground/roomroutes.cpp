@@ -0,0 +1,475 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+#include "roomroutes.hpp"
+
+//cells a search may visit, field coordinates, inclusive
+struct CellWindow {
+    int x0, z0, x1, z1;
+};
+
+//cost of the cheapest walk over the distance if nothing is in the way
+static int octileCost(int dx, int dz) {
+    dx = std::abs(dx);
+    dz = std::abs(dz);
+    return routeStraight * std::max(dx, dz) + (routeDiagonal - routeStraight) * std::min(dx, dz);
+}
+
+//field index of the cell a point is in, points outside count as the nearest cell inside
+static int pointCell(const RoomRoutes& routes, float x, float z) {
+    int gx = std::min(std::max(cellOf(x) - routes.minX, 1), routes.width - 2);
+    int gz = std::min(std::max(cellOf(z) - routes.minZ, 1), routes.depth - 2);
+    return gz * routes.width + gx;
+}
+
+static int entranceCell(const RoomRoutes& routes, const Entrance& entrance) {
+    return pointCell(routes, (float)entrance.x, (float)entrance.z);
+}
+
+//the cells up to margin around both cells, the blocked ring around the field is never inside
+static CellWindow windowAround(const RoomRoutes& routes, int a, int b, int margin) {
+    CellWindow window;
+    window.x0 = std::max(std::min(a % routes.width, b % routes.width) - margin, 1);
+    window.z0 = std::max(std::min(a / routes.width, b / routes.width) - margin, 1);
+    window.x1 = std::min(std::max(a % routes.width, b % routes.width) + margin, routes.width - 2);
+    window.z1 = std::min(std::max(a / routes.width, b / routes.width) + margin, routes.depth - 2);
+    return window;
+}
+
+static CellWindow wholeField(const RoomRoutes& routes) {
+    return { 1, 1, routes.width - 2, routes.depth - 2 };
+}
+
+static void pushOpen(RoomRoutes& routes, int cost, int index) {
+    routes.open.push_back((uint64_t)cost << 32 | (uint32_t)index);
+    std::push_heap(routes.open.begin(), routes.open.end(), std::greater<uint64_t>());
+}
+
+static uint64_t popOpen(RoomRoutes& routes) {
+    std::pop_heap(routes.open.begin(), routes.open.end(), std::greater<uint64_t>());
+    uint64_t top = routes.open.back();
+    routes.open.pop_back();
+    return top;
+}
+
+//the cell reached over move n costs less than it has so far, or wasn't reached yet in this search
+static bool improveCell(RoomRoutes& routes, int cell, int n, int cost, const CellWindow& window, int& neighbour, int& stepped) {
+    int nx = cell % routes.width + flowNeighbourX[n], nz = cell / routes.width + flowNeighbourZ[n];
+    neighbour = cell + flowNeighbourZ[n] * routes.width + flowNeighbourX[n];
+    if (nx < window.x0 || nx > window.x1 || nz < window.z0 || nz > window.z1 || routes.blocked[neighbour]) {
+        return false;
+    }
+    if (n >= 4 && (routes.blocked[cell + flowNeighbourX[n]] || routes.blocked[cell + flowNeighbourZ[n] * routes.width])) {
+        return false;
+    }
+    stepped = cost + (n < 4 ? routeStraight : routeDiagonal);
+    if (routes.cellStamp[neighbour] == routes.stamp && stepped >= routes.cellCost[neighbour]) {
+        return false;
+    }
+    routes.cellStamp[neighbour] = routes.stamp;
+    routes.cellCost[neighbour] = stepped;
+    routes.cellMove[neighbour] = (int8_t)n;
+    return true;
+}
+
+//Dijkstra from the cell over the whole window. No step costs more than 3, so the cells waiting to be expanded
+//only have 4 different costs and a ring of 4 lists replaces the heap
+static void spreadCells(RoomRoutes& routes, int from, const CellWindow& window) {
+    routes.stamp++;
+    for (std::vector<int>& costs : routes.ring) {
+        costs.clear();
+    }
+    if (routes.blocked[from]) {
+        return;
+    }
+    routes.cellStamp[from] = routes.stamp;
+    routes.cellCost[from] = 0;
+    routes.cellMove[from] = -1;
+    routes.ring[0].push_back(from);
+    int waiting = 1;
+    for (int cost = 0; waiting > 0; ++cost) {
+        std::vector<int>& current = routes.ring[cost % (routeDiagonal + 1)];
+        for (size_t i = 0; i < current.size(); ++i) {
+            int cell = current[i];
+            if (routes.cellCost[cell] != cost) {
+                continue;                           //reached cheaper since, already expanded
+            }
+            for (int n = 0; n < 8; ++n) {
+                int neighbour, stepped;
+                if (improveCell(routes, cell, n, cost, window, neighbour, stepped)) {
+                    routes.ring[stepped % (routeDiagonal + 1)].push_back(neighbour);
+                    waiting++;
+                }
+            }
+        }
+        waiting -= (int)current.size();
+        current.clear();
+    }
+}
+
+//A* over the 8 moves of the flow field inside the window, a diagonal only if both straight cells beside it are free.
+//Returns the cost to target, -1 if it isn't reached.
+static int searchCells(RoomRoutes& routes, int from, int target, const CellWindow& window) {
+    int targetX = target % routes.width, targetZ = target / routes.width;
+    auto heuristic = [&](int cell) {
+        return octileCost(cell % routes.width - targetX, cell / routes.width - targetZ);
+    };
+    routes.stamp++;
+    routes.open.clear();
+    if (routes.blocked[from]) {
+        return -1;
+    }
+    routes.cellStamp[from] = routes.stamp;
+    routes.cellCost[from] = 0;
+    routes.cellMove[from] = -1;
+    pushOpen(routes, heuristic(from), from);
+    while (!routes.open.empty()) {
+        uint64_t top = popOpen(routes);
+        int cell = (int)(uint32_t)top;
+        int cost = routes.cellCost[cell];
+        if ((int)(top >> 32) - heuristic(cell) > cost) {
+            continue;                               //reached cheaper since it was pushed
+        }
+        if (cell == target) {
+            return cost;
+        }
+        for (int n = 0; n < 8; ++n) {
+            int neighbour, stepped;
+            if (improveCell(routes, cell, n, cost, window, neighbour, stepped)) {
+                pushOpen(routes, stepped + heuristic(neighbour), neighbour);
+            }
+        }
+    }
+    return -1;
+}
+
+//the cells of the last search from its start to the cell, start first
+static void traceCells(const RoomRoutes& routes, int from, int to, std::vector<RouteCell>& cells) {
+    cells.clear();
+    for (int cell = to; ; ) {
+        cells.push_back({ routes.minX + cell % routes.width, routes.minZ + cell / routes.width });
+        if (cell == from) {
+            break;
+        }
+        int n = routes.cellMove[cell];
+        cell -= flowNeighbourZ[n] * routes.width + flowNeighbourX[n];
+    }
+    std::reverse(cells.begin(), cells.end());
+}
+
+//every room marks the cells inside its wall center line
+static void markRooms(RoomRoutes& routes, const RoomGraph& graph) {
+    routes.roomAt.assign(routes.blocked.size(), 0);
+    for (int r = 1; r < (int)graph.rooms.size(); ++r) {
+        const Room& room = graph.rooms[r];
+        int x0 = std::max(cellOf(room.centerX - room.halfSize) - routes.minX, 1);
+        int z0 = std::max(cellOf(room.centerZ - room.halfSize) - routes.minZ, 1);
+        int x1 = std::min(cellOf(room.centerX + room.halfSize) - routes.minX, routes.width - 2);
+        int z1 = std::min(cellOf(room.centerZ + room.halfSize) - routes.minZ, routes.depth - 2);
+        for (int gz = z0; gz <= z1; ++gz) {
+            for (int gx = x0; gx <= x1; ++gx) {
+                float dx = (float)(routes.minX + gx) - room.centerX, dz = (float)(routes.minZ + gz) - room.centerZ;
+                float distance = room.round ? std::sqrt(dx * dx + dz * dz) : std::max(std::abs(dx), std::abs(dz));
+                if (distance < room.halfSize) {
+                    routes.roomAt[gz * routes.width + gx] = r;
+                }
+            }
+        }
+    }
+}
+
+//drops every edge that is no shorter than going over another entrance, the shortest ways between entrances stay the same.
+//Both edges of such a detour are shorter than the one dropped, so one of them being dropped too still leaves a way as short
+static void pruneEdges(RoomRoutes& routes) {
+    int count = (int)routes.firstEdge.size() - 1;
+    std::vector<int> direct(count, -1);
+    std::vector<char> dropped(routes.edges.size(), 0);
+    for (int e = 0; e < count; ++e) {
+        for (int i = routes.firstEdge[e]; i < routes.firstEdge[e + 1]; ++i) {
+            direct[routes.edges[i].to] = i;
+        }
+        for (int i = routes.firstEdge[e]; i < routes.firstEdge[e + 1]; ++i) {
+            const RouteEdge& first = routes.edges[i];
+            for (int j = routes.firstEdge[first.to]; j < routes.firstEdge[first.to + 1]; ++j) {
+                const RouteEdge& second = routes.edges[j];
+                int shortcut = second.to == e ? -1 : direct[second.to];
+                if (shortcut >= 0 && first.cost + second.cost <= routes.edges[shortcut].cost) {
+                    dropped[shortcut] = 1;
+                }
+            }
+        }
+        for (int i = routes.firstEdge[e]; i < routes.firstEdge[e + 1]; ++i) {
+            direct[routes.edges[i].to] = -1;
+        }
+    }
+    std::vector<RouteEdge> kept;
+    for (int e = 0; e < count; ++e) {
+        int first = (int)kept.size();
+        for (int i = routes.firstEdge[e]; i < routes.firstEdge[e + 1]; ++i) {
+            if (!dropped[i]) {
+                kept.push_back(routes.edges[i]);
+            }
+        }
+        routes.firstEdge[e] = first;
+    }
+    routes.firstEdge[count] = (int)kept.size();
+    routes.edges.swap(kept);
+}
+
+static int bucketOf(const RoomRoutes& routes, int cell) {
+    return cell / routes.width / routeReach * routes.bucketsX + cell % routes.width / routeReach;
+}
+
+void initRoomRoutes(RoomRoutes& routes, const RoomGraph& graph, const FlowField& field) {
+    routes = RoomRoutes();
+    routes.minX = field.minX;
+    routes.minZ = field.minZ;
+    routes.width = field.width;
+    routes.depth = field.depth;
+    routes.blocked = field.blocked;
+    routes.entranceAt.assign(routes.blocked.size(), -1);
+    routes.cellCost.assign(routes.blocked.size(), 0);
+    routes.cellStamp.assign(routes.blocked.size(), 0);
+    routes.cellMove.assign(routes.blocked.size(), -1);
+    markRooms(routes, graph);
+    int count = (int)graph.entrances.size();
+    routes.nodeCost.assign(count + 1, 0);           //one more for the goal of a plan
+    routes.nodeFrom.assign(count + 1, -1);
+    routes.nodeStamp.assign(count + 1, 0);
+
+    routes.bucketsX = routes.width / routeReach + 1;
+    routes.bucketsZ = routes.depth / routeReach + 1;
+    routes.buckets.assign(routes.bucketsX * routes.bucketsZ, std::vector<int>());
+    for (int e = 0; e < count; ++e) {
+        int cell = entranceCell(routes, graph.entrances[e]);
+        routes.entranceAt[cell] = e;
+        routes.buckets[bucketOf(routes, cell)].push_back(e);
+    }
+
+    //everything an edge can reach is within routeReach, so in the bucket of the entrance or one next to it
+    routes.firstEdge.assign(count + 1, 0);
+    for (int e = 0; e < count; ++e) {
+        routes.firstEdge[e] = (int)routes.edges.size();
+        int cell = entranceCell(routes, graph.entrances[e]);
+        if (routes.blocked[cell]) {
+            continue;
+        }
+        spreadCells(routes, cell, windowAround(routes, cell, cell, routeReach));
+        int bucketX = cell % routes.width / routeReach, bucketZ = cell / routes.width / routeReach;
+        for (int bz = std::max(bucketZ - 1, 0); bz <= std::min(bucketZ + 1, routes.bucketsZ - 1); ++bz) {
+            for (int bx = std::max(bucketX - 1, 0); bx <= std::min(bucketX + 1, routes.bucketsX - 1); ++bx) {
+                for (int other : routes.buckets[bz * routes.bucketsX + bx]) {
+                    int otherCell = entranceCell(routes, graph.entrances[other]);
+                    if (other != e && routes.cellStamp[otherCell] == routes.stamp) {
+                        routes.edges.push_back({ other, routes.cellCost[otherCell] });
+                    }
+                }
+            }
+        }
+    }
+    routes.firstEdge[count] = (int)routes.edges.size();
+    pruneEdges(routes);
+}
+
+//the entrances a point in the room can walk to, costed as if nothing was in the way. In the arena those within
+//routeReach, or all of them if none is that close
+static void tieEntrances(const RoomRoutes& routes, const RoomGraph& graph, int room, int x, int z, std::vector<RouteEdge>& ties) {
+    ties.clear();
+    if (room != 0) {
+        for (int e : graph.rooms[room].entrances) {
+            ties.push_back({ e, octileCost(graph.entrances[e].x - x, graph.entrances[e].z - z) });
+        }
+        return;
+    }
+    int cell = pointCell(routes, (float)x, (float)z);
+    int bucketX = cell % routes.width / routeReach, bucketZ = cell / routes.width / routeReach;
+    for (int bz = std::max(bucketZ - 1, 0); bz <= std::min(bucketZ + 1, routes.bucketsZ - 1); ++bz) {
+        for (int bx = std::max(bucketX - 1, 0); bx <= std::min(bucketX + 1, routes.bucketsX - 1); ++bx) {
+            for (int e : routes.buckets[bz * routes.bucketsX + bx]) {
+                int dx = graph.entrances[e].x - x, dz = graph.entrances[e].z - z;
+                if (std::abs(dx) <= routeReach && std::abs(dz) <= routeReach) {
+                    ties.push_back({ e, octileCost(dx, dz) });
+                }
+            }
+        }
+    }
+    if (ties.empty()) {
+        for (int e = 0; e < (int)graph.entrances.size(); ++e) {
+            ties.push_back({ e, octileCost(graph.entrances[e].x - x, graph.entrances[e].z - z) });
+        }
+    }
+}
+
+//A* over the entrances from the sources (with their cost from the start) to a goal point the goals are tied to.
+//The heuristic is the cost with nothing in the way, no edge is cheaper than that. Returns the cost, -1 if there is no way
+static int searchEntrances(RoomRoutes& routes, const RoomGraph& graph, const std::vector<RouteEdge>& sources, const std::vector<RouteEdge>& goals, int goalX, int goalZ, std::vector<int>& path) {
+    int goalNode = (int)graph.entrances.size();
+    auto heuristic = [&](int node) {
+        return node == goalNode ? 0 : octileCost(graph.entrances[node].x - goalX, graph.entrances[node].z - goalZ);
+    };
+    auto reach = [&](int node, int cost, int from) {
+        if (routes.nodeStamp[node] != routes.stamp || cost < routes.nodeCost[node]) {
+            routes.nodeStamp[node] = routes.stamp;
+            routes.nodeCost[node] = cost;
+            routes.nodeFrom[node] = from;
+            pushOpen(routes, cost + heuristic(node), node);
+        }
+    };
+    routes.stamp++;
+    routes.open.clear();
+    for (const RouteEdge& source : sources) {
+        reach(source.to, source.cost, -1);
+    }
+    while (!routes.open.empty()) {
+        uint64_t top = popOpen(routes);
+        int node = (int)(uint32_t)top;
+        int cost = routes.nodeCost[node];
+        if ((int)(top >> 32) - heuristic(node) > cost) {
+            continue;
+        }
+        if (node == goalNode) {
+            path.clear();
+            for (int e = routes.nodeFrom[goalNode]; e >= 0; e = routes.nodeFrom[e]) {
+                path.push_back(e);
+            }
+            std::reverse(path.begin(), path.end());
+            return cost;
+        }
+        for (const RouteEdge& goal : goals) {
+            if (goal.to == node) {
+                reach(goalNode, cost + goal.cost, node);
+            }
+        }
+        for (int i = routes.firstEdge[node]; i < routes.firstEdge[node + 1]; ++i) {
+            reach(routes.edges[i].to, cost + routes.edges[i].cost, node);
+        }
+    }
+    return -1;
+}
+
+//the ways from every entrance of one room to every entrance of the other, searched once per pair of rooms
+static const RoomPairRoutes& roomPair(RoomRoutes& routes, const RoomGraph& graph, int fromRoom, int toRoom) {
+    uint64_t key = (uint64_t)fromRoom << 32 | (uint32_t)toRoom;
+    auto cached = routes.pairs.find(key);
+    if (cached != routes.pairs.end()) {
+        routes.stats.pairHits++;
+        return cached->second;
+    }
+    routes.stats.pairMisses++;
+    const std::vector<int>& from = graph.rooms[fromRoom].entrances;
+    const std::vector<int>& to = graph.rooms[toRoom].entrances;
+    RoomPairRoutes& pair = routes.pairs[key];
+    pair.cost.assign(from.size() * to.size(), -1);
+    pair.entrances.resize(from.size() * to.size());
+    for (size_t a = 0; a < from.size(); ++a) {
+        for (size_t b = 0; b < to.size(); ++b) {
+            const Entrance& goal = graph.entrances[to[b]];
+            size_t i = a * to.size() + b;
+            pair.cost[i] = searchEntrances(routes, graph, { { from[a], 0 } }, { { to[b], 0 } }, goal.x, goal.z, pair.entrances[i]);
+        }
+    }
+    return pair;
+}
+
+bool planRoute(RoomRoutes& routes, const RoomGraph& graph, float fromX, float fromZ, float toX, float toZ, RoutePlan& plan) {
+    routes.stats.plans++;
+    plan.fromX = fromX;
+    plan.fromZ = fromZ;
+    plan.toX = toX;
+    plan.toZ = toZ;
+    plan.entrances.clear();
+    plan.found = false;
+    int x0 = cellOf(fromX), z0 = cellOf(fromZ), x1 = cellOf(toX), z1 = cellOf(toZ);
+    int fromRoom = routes.roomAt[pointCell(routes, fromX, fromZ)];
+    int toRoom = routes.roomAt[pointCell(routes, toX, toZ)];
+
+    //in the same room or close by in the arena it is one leg
+    if (fromRoom == toRoom && (fromRoom != 0 || (std::abs(x1 - x0) <= routeReach && std::abs(z1 - z0) <= routeReach))) {
+        plan.cost = octileCost(x1 - x0, z1 - z0);
+        plan.found = true;
+        return true;
+    }
+
+    if (fromRoom != 0 && toRoom != 0 && fromRoom != toRoom) {
+        const RoomPairRoutes& pair = roomPair(routes, graph, fromRoom, toRoom);
+        const std::vector<int>& from = graph.rooms[fromRoom].entrances;
+        const std::vector<int>& to = graph.rooms[toRoom].entrances;
+        int best = -1;
+        for (size_t a = 0; a < from.size(); ++a) {
+            for (size_t b = 0; b < to.size(); ++b) {
+                size_t i = a * to.size() + b;
+                if (pair.cost[i] < 0) {
+                    continue;
+                }
+                const Entrance& first = graph.entrances[from[a]];
+                const Entrance& last = graph.entrances[to[b]];
+                int cost = octileCost(first.x - x0, first.z - z0) + pair.cost[i] + octileCost(x1 - last.x, z1 - last.z);
+                if (best < 0 || cost < plan.cost) {
+                    best = (int)i;
+                    plan.cost = cost;
+                }
+            }
+        }
+        if (best < 0) {
+            return false;
+        }
+        plan.entrances = pair.entrances[best];
+        plan.found = true;
+        return true;
+    }
+
+    std::vector<RouteEdge> sources, goals;
+    tieEntrances(routes, graph, fromRoom, x0, z0, sources);
+    tieEntrances(routes, graph, toRoom, x1, z1, goals);
+    plan.cost = searchEntrances(routes, graph, sources, goals, x1, z1, plan.entrances);
+    plan.found = plan.cost >= 0;
+    return plan.found;
+}
+
+int routeLegs(const RoutePlan& plan) {
+    return plan.found ? (int)plan.entrances.size() + 1 : 0;
+}
+
+bool refineLeg(RoomRoutes& routes, const RoomGraph& graph, const RoutePlan& plan, int leg, std::vector<RouteCell>& cells) {
+    int count = (int)plan.entrances.size();
+    int from = leg == 0 ? pointCell(routes, plan.fromX, plan.fromZ) : entranceCell(routes, graph.entrances[plan.entrances[leg - 1]]);
+    int to = leg == count ? pointCell(routes, plan.toX, plan.toZ) : entranceCell(routes, graph.entrances[plan.entrances[leg]]);
+
+    //between two entrances it is the walk the edge was measured on, that is the same for every plan
+    bool betweenEntrances = leg > 0 && leg < count;
+    uint64_t key = betweenEntrances ? (uint64_t)plan.entrances[leg - 1] << 32 | (uint32_t)plan.entrances[leg] : 0;
+    if (betweenEntrances) {
+        auto cached = routes.legs.find(key);
+        if (cached != routes.legs.end()) {
+            routes.stats.legHits++;
+            cells = cached->second;
+            return true;
+        }
+    }
+
+    routes.stats.legSearches++;
+    CellWindow window = betweenEntrances ? windowAround(routes, from, from, routeReach) : windowAround(routes, from, to, routeReach / 2);
+    if (searchCells(routes, from, to, window) < 0) {
+        //a wall in the way is longer than the window is wide
+        routes.stats.widened++;
+        if (searchCells(routes, from, to, wholeField(routes)) < 0) {
+            return false;
+        }
+    }
+    traceCells(routes, from, to, cells);
+    if (betweenEntrances) {
+        routes.legs[key] = cells;
+    }
+    return true;
+}
+
+int searchRouteCells(RoomRoutes& routes, float fromX, float fromZ, float toX, float toZ, std::vector<RouteCell>* cells) {
+    int from = pointCell(routes, fromX, fromZ), to = pointCell(routes, toX, toZ);
+    int cost = searchCells(routes, from, to, wholeField(routes));
+    if (cost >= 0 && cells) {
+        traceCells(routes, from, to, *cells);
+    }
+    return cost;
+}
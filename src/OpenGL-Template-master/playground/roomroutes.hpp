@@ -0,0 +1,83 @@
+#ifndef ROOMROUTES_HPP
+#define ROOMROUTES_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "flowfield.hpp"
+#include "rooms.hpp"
+
+//Routes across the level planned in two levels, like HPA*. The entrances of the rooms (rooms.hpp) are the nodes of a
+//small graph, an edge is the shortest walk from one entrance to another that stays within routeReach cells of the first.
+//A route is first searched on that graph, with its start and goal tied to the entrances of the rooms they are in, and
+//a leg of it is only searched cell by cell when an agent is about to walk it. Routes between two rooms and the legs
+//between two entrances are cached, so planning between rooms again costs a few lookups.
+//Nothing in the game plans with it yet, chasing the player is the flow field's job (flowfield.hpp) and it reaches every
+//cell a route could. It is meant for patrol and flanking routes, which come with a later change; until then only
+//roomroutes_bench uses it.
+
+const int routeReach = 40;                          //cells around an entrance its edges are searched in
+const int routeStraight = 2, routeDiagonal = 3;     //cost of a step, a diagonal is about 1.5 straight ones
+
+struct RouteEdge {
+    int to;
+    int cost;
+};
+
+struct RouteCell {
+    int x, z;                                       //world coordinate of the cell's center
+};
+
+//best entrance pair and the entrances in between for every entrance of one room to every entrance of another
+struct RoomPairRoutes {
+    std::vector<int> cost;                          //[from * toCount + to], -1 if there is no way
+    std::vector<std::vector<int>> entrances;        //same index, from the first to the last entrance
+};
+
+struct RouteStats {
+    int plans = 0;
+    int pairHits = 0, pairMisses = 0;               //plans between two rooms, found in the cache or not
+    int legHits = 0, legSearches = 0;               //legs refined from the cache or by a cell search
+    int widened = 0;                                //leg searches that had to look beyond their window
+};
+
+struct RoomRoutes {
+    int minX = 0, minZ = 0, width = 0, depth = 0;   //the cells of the chase flow field
+    std::vector<uint8_t> blocked;
+    std::vector<int> entranceAt;                    //entrance in the cell or -1
+    std::vector<int> roomAt;                        //room the cell is inside of, 0 for the arena, walls and gaps
+    std::vector<int> firstEdge;                     //edges of entrance e are edges[firstEdge[e]] up to firstEdge[e + 1]
+    std::vector<RouteEdge> edges;                   //none that two other edges are as short as together
+    int bucketsX = 0, bucketsZ = 0;                 //entrances sorted into squares of routeReach cells
+    std::vector<std::vector<int>> buckets;
+    std::unordered_map<uint64_t, RoomPairRoutes> pairs;
+    std::unordered_map<uint64_t, std::vector<RouteCell>> legs;
+
+    //kept allocated between searches, a cell or entrance counts as visited if its stamp is the current one
+    std::vector<int> cellCost;
+    std::vector<uint32_t> cellStamp;
+    std::vector<int8_t> cellMove;                   //neighbour index (flowfield.hpp) the cell was reached by
+    std::vector<int> nodeCost, nodeFrom;
+    std::vector<uint32_t> nodeStamp;
+    std::vector<uint64_t> open;                     //heap of cost << 32 | index
+    std::vector<int> ring[routeDiagonal + 1];       //cells by cost modulo 4 while spreading out from an entrance
+    uint32_t stamp = 0;
+    RouteStats stats;
+};
+
+//a route from one point to another, through entrances
+struct RoutePlan {
+    float fromX = 0.0f, fromZ = 0.0f, toX = 0.0f, toZ = 0.0f;
+    std::vector<int> entrances;                     //in walking order, empty if the goal is reached without any
+    int cost = 0;                                   //in step costs, from and to the points as if nothing was in the way
+    bool found = false;
+};
+
+void initRoomRoutes(RoomRoutes& routes, const RoomGraph& graph, const FlowField& field); //<<< searches the edges between the entrances, on the cells of the field
+bool planRoute(RoomRoutes& routes, const RoomGraph& graph, float fromX, float fromZ, float toX, float toZ, RoutePlan& plan); //<<< only on the entrance graph, false if there is no way
+int routeLegs(const RoutePlan& plan); //<<< from the start to the first entrance, between the entrances and to the goal
+bool refineLeg(RoomRoutes& routes, const RoomGraph& graph, const RoutePlan& plan, int leg, std::vector<RouteCell>& cells); //<<< the cells to walk, the leg's start cell first. False if it can't be walked
+int searchRouteCells(RoomRoutes& routes, float fromX, float fromZ, float toX, float toZ, std::vector<RouteCell>* cells); //<<< plain A* over all cells, cost or -1, what a plan is checked against
+
+#endif
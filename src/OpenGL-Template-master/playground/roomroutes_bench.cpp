@@ -0,0 +1,182 @@
+//Benchmark for route planning over the room entrances, no window needed.
+//On level 1 and on a generated map of 1000 rooms it plans routes between random free cells and refines every leg.
+//The legs have to be walkable and join up from start to goal, and a route has to be found wherever A* over all
+//cells finds one. Timed are building the entrance graph, planning (the first time and again from the room pair
+//cache), refining and the plain A* the plans replace.
+//usage: roomroutes_bench [routes]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "benchutil.hpp"
+#include "roomroutes.hpp"
+#include "simulation.hpp"
+
+struct Query {
+    float fromX, fromZ, toX, toZ;
+};
+
+static bool blockedAt(const RoomRoutes& routes, int x, int z) {
+    int gx = x - routes.minX, gz = z - routes.minZ;
+    return gx < 0 || gz < 0 || gx >= routes.width || gz >= routes.depth || routes.blocked[gz * routes.width + gx];
+}
+
+static int roomAt(const RoomRoutes& routes, float x, float z) {
+    return routes.roomAt[((int)z - routes.minZ) * routes.width + (int)x - routes.minX];
+}
+
+//every step one of the 8 moves onto a free cell, diagonals not past a wall corner. Adds the steps' cost
+static bool walkable(const RoomRoutes& routes, const std::vector<RouteCell>& cells, int& cost) {
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (blockedAt(routes, cells[i].x, cells[i].z)) {
+            return false;
+        }
+        if (i == 0) {
+            continue;
+        }
+        int dx = cells[i].x - cells[i - 1].x, dz = cells[i].z - cells[i - 1].z;
+        if (std::abs(dx) > 1 || std::abs(dz) > 1 || (dx == 0 && dz == 0)) {
+            return false;
+        }
+        if (dx != 0 && dz != 0 && (blockedAt(routes, cells[i - 1].x + dx, cells[i - 1].z) || blockedAt(routes, cells[i - 1].x, cells[i - 1].z + dz))) {
+            return false;
+        }
+        cost += dx != 0 && dz != 0 ? routeDiagonal : routeStraight;
+    }
+    return true;
+}
+
+//square rooms on a grid with gaps in between, each with a random set of at least one door
+static void generateRoomMap(int roomCount, Rng& rng, std::vector<wall>& walls, RoomGraph& graph, float& platformSize) {
+    const int spacing = 24;
+    int columns = (int)std::ceil(std::sqrt((double)roomCount));
+    platformSize = (float)((columns + 1) * spacing);
+    walls.clear();
+    graph = RoomGraph();
+    for (int i = 0; i < roomCount; ++i) {
+        int centerX = (i % columns - columns / 2) * spacing;
+        int centerZ = (i / columns - columns / 2) * spacing;
+        int roomSize = 8 + 2 * randomInt(rng, 5);
+        int doors = 1 + randomInt(rng, allDoors);
+        int firstWall = (int)walls.size();
+        createSquareRoom(walls, rng, centerX, centerZ, roomSize, 5.0f, doors);
+        addSquareRoom(graph, walls, firstWall, centerX, centerZ, roomSize, doors);
+    }
+    connectRooms(graph, walls);
+}
+
+//plans, refines and checks the queries on one map, returns the number of routes that failed a check
+static int benchMap(const char* name, const RoomGraph& graph, const FlowField& field, int queryCount, Rng& rng) {
+    RoomRoutes routes;
+    auto start = std::chrono::steady_clock::now();
+    initRoomRoutes(routes, graph, field);
+    double buildSeconds = secondsSince(start);
+    printf("%s: %d rooms, %d entrances, %d edges, graph built in %.1f ms\n", name, (int)graph.rooms.size() - 1, (int)graph.entrances.size(),
+           (int)routes.edges.size(), buildSeconds * 1e3);
+
+    std::vector<Query> queries(queryCount);
+    for (Query& query : queries) {
+        int x, z;
+        do {
+            x = field.minX + randomInt(rng, field.width);
+            z = field.minZ + randomInt(rng, field.depth);
+        } while (blockedAt(routes, x, z));
+        query.fromX = (float)x;
+        query.fromZ = (float)z;
+        do {
+            x = field.minX + randomInt(rng, field.width);
+            z = field.minZ + randomInt(rng, field.depth);
+        } while (blockedAt(routes, x, z));
+        query.toX = (float)x;
+        query.toZ = (float)z;
+    }
+
+    //first time every pair of rooms misses the cache, the second time all of them hit. From or to the arena there is
+    //no room pair, those are searched on the entrance graph every time
+    std::vector<RoutePlan> plans(queryCount);
+    double roomSeconds[2] = { 0.0, 0.0 }, arenaSeconds = 0.0;
+    int betweenRooms = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < queryCount; ++i) {
+            const Query& query = queries[i];
+            bool rooms = roomAt(routes, query.fromX, query.fromZ) != 0 && roomAt(routes, query.toX, query.toZ) != 0;
+            start = std::chrono::steady_clock::now();
+            planRoute(routes, graph, query.fromX, query.fromZ, query.toX, query.toZ, plans[i]);
+            double seconds = secondsSince(start);
+            if (rooms) {
+                roomSeconds[pass] += seconds;
+                betweenRooms += pass == 0;
+            } else {
+                arenaSeconds += seconds;
+            }
+        }
+    }
+    int pairMisses = routes.stats.pairMisses;
+
+    int failed = 0, notFound = 0, legs = 0;
+    double refineSeconds = 0.0, astarSeconds = 0.0, ratioSum = 0.0, worstRatio = 1.0;
+    std::vector<RouteCell> cells;
+    for (int i = 0; i < queryCount; ++i) {
+        const Query& query = queries[i];
+        start = std::chrono::steady_clock::now();
+        int optimal = searchRouteCells(routes, query.fromX, query.fromZ, query.toX, query.toZ, nullptr);
+        astarSeconds += secondsSince(start);
+        if (!plans[i].found) {
+            notFound++;
+            failed += optimal >= 0;
+            continue;
+        }
+
+        int cost = 0;
+        bool valid = true;
+        RouteCell end = { (int)query.fromX, (int)query.fromZ };
+        for (int leg = 0; leg < routeLegs(plans[i]) && valid; ++leg) {
+            start = std::chrono::steady_clock::now();
+            valid = refineLeg(routes, graph, plans[i], leg, cells);
+            refineSeconds += secondsSince(start);
+            valid = valid && cells.front().x == end.x && cells.front().z == end.z && walkable(routes, cells, cost);
+            end = cells.back();
+            legs++;
+        }
+        valid = valid && end.x == (int)query.toX && end.z == (int)query.toZ;
+        if (!valid || optimal < 0) {
+            failed++;
+            continue;
+        }
+        double ratio = optimal > 0 ? (double)cost / optimal : 1.0;
+        ratioSum += ratio;
+        worstRatio = std::max(worstRatio, ratio);
+    }
+    int walked = queryCount - notFound;
+    printf("  plan between rooms: %.2f us first, %.2f us again (%d routes, %d room pairs searched)\n", roomSeconds[0] / std::max(betweenRooms, 1) * 1e6,
+           roomSeconds[1] / std::max(betweenRooms, 1) * 1e6, betweenRooms, pairMisses);
+    printf("  plan from or to the arena: %.2f us (%d routes)\n", arenaSeconds / std::max(2 * (queryCount - betweenRooms), 1) * 1e6, queryCount - betweenRooms);
+    printf("  refine: %.1f us per leg (%d legs, %d searched, %d from the cache, %d widened)\n", refineSeconds / std::max(legs, 1) * 1e6, legs,
+           routes.stats.legSearches, routes.stats.legHits, routes.stats.widened);
+    printf("  walked %.3fx the shortest way on average, %.3fx at worst\n", ratioSum / std::max(walked, 1), worstRatio);
+    printf("  A* over all cells: %.1f us per route\n", astarSeconds / queryCount * 1e6);
+    printf("  %d of %d routes failed a check, %d had no way\n\n", failed, queryCount, notFound);
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    int queryCount = argc > 1 ? std::atoi(argv[1]) : 400;
+    Rng rng = seedRng(11);
+
+    GameState game;
+    startGame(game, 1, 1, 0.0);
+    int failed = benchMap("level 1", game.rooms, game.chase, queryCount, rng);
+
+    std::vector<wall> walls;
+    RoomGraph graph;
+    float platformSize;
+    generateRoomMap(1000, rng, walls, graph, platformSize);
+    WallGrid grid = buildWallGrid(walls);
+    FlowField field;
+    initFlowField(field, grid, platformSize);
+    failed += benchMap("1000 rooms", graph, field, queryCount, rng);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cmath>
+
+#include "rooms.hpp"
+
+static float lowestWallFrom(const std::vector<wall>& walls, int firstWall) {
+    float lowest = 0.0f;
+    for (int i = firstWall; i < (int)walls.size(); ++i) {
+        lowest = i == firstWall ? walls[i].h : std::min(lowest, walls[i].h);
+    }
+    return lowest;
+}
+
+static void ensureArena(RoomGraph& graph) {
+    if (graph.rooms.empty()) {
+        graph.rooms.push_back(Room());
+    }
+}
+
+void addSquareRoom(RoomGraph& graph, const std::vector<wall>& walls, int firstWall, int centerX, int centerZ, int roomSize, int doors) {
+    ensureArena(graph);
+    Room room;
+    room.centerX = (float)centerX;
+    room.centerZ = (float)centerZ;
+    room.halfSize = (float)(roomSize / 2);
+    room.doors = doors;
+    room.lowestWall = lowestWallFrom(walls, firstWall);
+    graph.rooms.push_back(room);
+}
+
+void addRoundRoom(RoomGraph& graph, const std::vector<wall>& walls, int firstWall, int centerX, int centerZ, int radius, int doors) {
+    ensureArena(graph);
+    Room room;
+    room.centerX = (float)centerX;
+    room.centerZ = (float)centerZ;
+    room.halfSize = (float)radius;
+    room.round = true;
+    room.doors = doors;
+    room.lowestWall = lowestWallFrom(walls, firstWall);
+    graph.rooms.push_back(room);
+}
+
+//the same rectangle from both sides, into the room and out of it
+static void addPortalPair(RoomGraph& graph, int room, int axis, float inward, const float boxMin[3], const float boxMax[3]) {
+    Portal in = { room, axis, inward, { boxMin[0], boxMin[1], boxMin[2] }, { boxMax[0], boxMax[1], boxMax[2] } };
+    Portal out = in;
+    out.toRoom = 0;
+    out.direction = -inward;
+    graph.rooms[0].portals.push_back(in);
+    graph.rooms[room].portals.push_back(out);
+}
+
+void connectRooms(RoomGraph& graph, const std::vector<wall>& walls) {
+    ensureArena(graph);
+    //nothing is higher than the highest wall, a ray above it can't hit anything anymore
+    float top = 0.0f;
+    for (const wall& w : walls) {
+        top = std::max(top, w.h);
+    }
+
+    const int sideDoors[4] = { doorPlusX, doorMinusX, doorPlusZ, doorMinusZ };
+    const float sideSign[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+    graph.entrances.clear();
+    for (int r = 1; r < (int)graph.rooms.size(); ++r) {
+        Room& room = graph.rooms[r];
+        room.entrances.clear();
+        for (int side = 0; side < 4; ++side) {
+            int axis = side < 2 ? 0 : 2;
+            int across = axis == 0 ? 2 : 0;
+            float center[3] = { room.centerX, 0.0f, room.centerZ };
+
+            //the gap is on the wall line at halfSize, for round rooms too
+            if (room.doors & sideDoors[side]) {
+                int outwardX = axis == 0 ? (int)sideSign[side] : 0;
+                int outwardZ = axis == 2 ? (int)sideSign[side] : 0;
+                int halfSize = (int)room.halfSize;
+                Entrance entrance = { r, (int)room.centerX + outwardX * halfSize, (int)room.centerZ + outwardZ * halfSize, outwardX, outwardZ };
+                room.entrances.push_back((int)graph.entrances.size());
+                graph.entrances.push_back(entrance);
+            }
+
+            float boxMin[3], boxMax[3];
+            if (room.round) {
+                //the whole side of the bounding square, all the way down
+                boxMin[axis] = boxMax[axis] = center[axis] + sideSign[side] * (room.halfSize + 0.5f);
+                boxMin[across] = center[across] - room.halfSize - 0.5f;
+                boxMax[across] = center[across] + room.halfSize + 0.5f;
+                boxMin[1] = 0.0f;
+                boxMax[1] = top;
+                addPortalPair(graph, r, axis, -sideSign[side], boxMin, boxMax);
+                continue;
+            }
+
+            //over the walls of the side, above its lowest wall
+            boxMin[axis] = boxMax[axis] = center[axis] + sideSign[side] * room.halfSize;
+            boxMin[across] = center[across] - room.halfSize - 0.5f;
+            boxMax[across] = center[across] + room.halfSize + 0.5f;
+            boxMin[1] = room.lowestWall;
+            boxMax[1] = top;
+            addPortalPair(graph, r, axis, -sideSign[side], boxMin, boxMax);
+
+            //the 3 wide entrance in the middle of the side
+            if (room.doors & sideDoors[side]) {
+                boxMin[across] = center[across] - 1.5f;
+                boxMax[across] = center[across] + 1.5f;
+                boxMin[1] = 0.0f;
+                addPortalPair(graph, r, axis, -sideSign[side], boxMin, boxMax);
+            }
+        }
+    }
+}
+
+//from the room center to the point, as a square or a circle depending on the room
+static float distanceToCenter(const Room& room, float x, float z) {
+    float dx = x - room.centerX, dz = z - room.centerZ;
+    return room.round ? std::sqrt(dx * dx + dz * dz) : std::max(std::abs(dx), std::abs(dz));
+}
+
+int roomOfPoint(const RoomGraph& graph, float x, float z, bool& onBoundary) {
+    onBoundary = false;
+    for (int r = 1; r < (int)graph.rooms.size(); ++r) {
+        const Room& room = graph.rooms[r];
+        float distance = distanceToCenter(room, x, z);
+        //walls are one cell thick, the ring of a round room two
+        float inner = room.halfSize - (room.round ? 2.0f : 1.0f);
+        float outer = room.halfSize + 1.0f;
+        if (distance <= outer) {
+            onBoundary = distance >= inner;
+            return r;
+        }
+    }
+    return 0;
+}
+
+//view volume of everything seen through the portal: the planes from the eye along its four edges
+//plus the camera's near and far plane. False if the eye is too close to the portal or on the wrong side of it.
+static bool portalFrustum(const Portal& portal, const Frustum& camera, const float eye[3], Frustum& out) {
+    float plane = portal.boxMin[portal.axis];
+    if ((eye[portal.axis] - plane) * portal.direction > -1.0f) {
+        return false;
+    }
+
+    int across = portal.axis == 0 ? 2 : 0;
+    float corners[4][3];
+    for (int i = 0; i < 4; ++i) {
+        corners[i][portal.axis] = plane;
+    }
+    corners[0][across] = portal.boxMin[across]; corners[0][1] = portal.boxMin[1];
+    corners[1][across] = portal.boxMax[across]; corners[1][1] = portal.boxMin[1];
+    corners[2][across] = portal.boxMax[across]; corners[2][1] = portal.boxMax[1];
+    corners[3][across] = portal.boxMin[across]; corners[3][1] = portal.boxMax[1];
+    float middle[3];
+    for (int k = 0; k < 3; ++k) {
+        middle[k] = (portal.boxMin[k] + portal.boxMax[k]) * 0.5f;
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        const float* a = corners[i];
+        const float* b = corners[(i + 1) % 4];
+        float u[3] = { a[0] - eye[0], a[1] - eye[1], a[2] - eye[2] };
+        float v[3] = { b[0] - eye[0], b[1] - eye[1], b[2] - eye[2] };
+        float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length < 1e-6f) {
+            return false;
+        }
+        float d = -(n[0] * eye[0] + n[1] * eye[1] + n[2] * eye[2]);
+        //the middle of the portal has to be inside
+        float sign = n[0] * middle[0] + n[1] * middle[1] + n[2] * middle[2] + d >= 0.0f ? 1.0f : -1.0f;
+        out.a[i] = sign * n[0] / length;
+        out.b[i] = sign * n[1] / length;
+        out.c[i] = sign * n[2] / length;
+        out.d[i] = sign * d / length;
+    }
+    for (int p = 4; p < 6; ++p) {
+        out.a[p] = camera.a[p];
+        out.b[p] = camera.b[p];
+        out.c[p] = camera.c[p];
+        out.d[p] = camera.d[p];
+    }
+    return true;
+}
+
+static bool insideVolume(const ViewVolume& volume, const float boxMin[3], const float boxMax[3]) {
+    for (int i = 0; i < volume.count; ++i) {
+        if (!boxVisible(volume.portals[i], boxMin, boxMax)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void visitRoom(const RoomGraph& graph, int room, ViewVolume& path, const Frustum& camera, const float eye[3], RoomVisibility& visibility) {
+    if (visibility.volumes[room].empty()) {
+        visibility.roomsVisible++;
+    }
+    visibility.volumes[room].push_back(path);
+    std::vector<char>& onPath = visibility.onPath;
+    onPath[room] = 1;
+    for (const Portal& portal : graph.rooms[room].portals) {
+        //a room is entered at most once per chain, going back out the way one came in shows nothing new
+        if (onPath[portal.toRoom] || !boxVisible(camera, portal.boxMin, portal.boxMax) || !insideVolume(path, portal.boxMin, portal.boxMax)) {
+            continue;
+        }
+        //standing in the portal nothing is narrowed, everything the chain so far sees may be behind it
+        bool narrowed = path.count < maxPortalDepth && portalFrustum(portal, camera, eye, path.portals[path.count]);
+        path.count += narrowed;
+        visitRoom(graph, portal.toRoom, path, camera, eye, visibility);
+        path.count -= narrowed;
+    }
+    onPath[room] = 0;
+}
+
+void findVisibleRooms(const RoomGraph& graph, const Frustum& camera, const float eye[3], RoomVisibility& visibility) {
+    visibility.volumes.resize(std::max((size_t)1, graph.rooms.size()));
+    for (std::vector<ViewVolume>& volumes : visibility.volumes) {
+        volumes.clear();
+    }
+    visibility.roomsVisible = 0;
+    if (graph.rooms.empty()) {
+        visibility.volumes[0].push_back(ViewVolume());
+        visibility.roomsVisible = 1;
+        return;
+    }
+    //the eye belongs to the side of the wall center line it is on, close to a portal the volumes fall back to the camera's anyway
+    int start = 0;
+    for (int r = 1; r < (int)graph.rooms.size(); ++r) {
+        if (distanceToCenter(graph.rooms[r], eye[0], eye[2]) < graph.rooms[r].halfSize) {
+            start = r;
+        }
+    }
+    visibility.onPath.assign(graph.rooms.size(), 0);
+    ViewVolume path;
+    visitRoom(graph, start, path, camera, eye, visibility);
+}
+
+bool boxVisibleInRoom(const RoomVisibility& visibility, int room, bool onBoundary, const float boxMin[3], const float boxMax[3]) {
+    for (const ViewVolume& volume : visibility.volumes[room]) {
+        if (insideVolume(volume, boxMin, boxMax)) {
+            return true;
+        }
+    }
+    if (room != 0 && onBoundary) {
+        return boxVisibleInRoom(visibility, 0, false, boxMin, boxMax);
+    }
+    return false;
+}
@@ -0,0 +1,71 @@
+#ifndef ROOMS_HPP
+#define ROOMS_HPP
+
+#include <vector>
+
+#include "frustum.hpp"
+#include "wallgrid.hpp"
+
+//Rooms of a level and the openings between them, filled by generatelevel.
+//Every room is enclosed by its walls except for its doors, so from one room into another
+//can only be seen through a door or over the lowest wall of a side.
+
+const int doorPlusX = 1, doorMinusX = 2, doorPlusZ = 4, doorMinusZ = 8;
+const int allDoors = doorPlusX | doorMinusX | doorPlusZ | doorMinusZ;
+
+//a rectangle in a wall plane, everything seen through it from one room lies in toRoom
+struct Portal {
+    int toRoom;
+    int axis;                                       //0: lies in a plane x = const, 2: in a plane z = const
+    float direction;                                //+1 or -1, the side of the plane toRoom is on
+    float boxMin[3], boxMax[3];                     //flat in axis
+};
+
+//a 3 wide gap in the middle of a room's side, leads from the room out into the arena.
+//The entrances are the nodes route planning (roomroutes.hpp) searches first.
+struct Entrance {
+    int room;
+    int x, z;                                       //middle cell of the gap, on the wall center line
+    int outwardX, outwardZ;                         //one cell step from inside the room to the arena
+};
+
+struct Room {
+    float centerX = 0.0f, centerZ = 0.0f;
+    float halfSize = 0.0f;                          //from the center to the wall center line, the radius for round rooms
+    bool round = false;                             //round walls are not followed, such a room hides nothing
+    int doors = 0;
+    float lowestWall = 0.0f;                        //a side hides only what is seen below its lowest wall
+    std::vector<Portal> portals;
+    std::vector<int> entrances;                     //into RoomGraph::entrances
+};
+
+struct RoomGraph {
+    std::vector<Room> rooms;                        //rooms[0] is the open arena around the rooms, it has no walls of its own
+    std::vector<Entrance> entrances;                //of all rooms, the arena is on the other side of every one
+};
+
+const int maxPortalDepth = 4;                       //portals on the way from the camera's room to another one
+
+//what is seen through a chain of portals: only boxes inside the volumes of all of them
+struct ViewVolume {
+    Frustum portals[maxPortalDepth];
+    int count = 0;                                  //0 for the camera's own room, which only has the camera frustum
+};
+
+//what one camera can see: for every room the chains of portals that lead into it.
+//Owned by the caller and filled again every frame, the vectors stay allocated in between
+struct RoomVisibility {
+    std::vector<std::vector<ViewVolume>> volumes;
+    int roomsVisible = 0;
+    std::vector<char> onPath;                       //rooms on the chain being walked
+};
+
+void addSquareRoom(RoomGraph& graph, const std::vector<wall>& walls, int firstWall, int centerX, int centerZ, int roomSize, int doors); //<<< walls from firstWall on are the room's
+void addRoundRoom(RoomGraph& graph, const std::vector<wall>& walls, int firstWall, int centerX, int centerZ, int radius, int doors); //<<< walls from firstWall on are the room's
+void connectRooms(RoomGraph& graph, const std::vector<wall>& walls); //<<< builds the portals and entrances between the arena and every room, after all rooms are added
+
+int roomOfPoint(const RoomGraph& graph, float x, float z, bool& onBoundary); //<<< 0 for the arena, onBoundary near a room's walls where it can also be seen from the arena
+void findVisibleRooms(const RoomGraph& graph, const Frustum& camera, const float eye[3], RoomVisibility& visibility); //<<< walks the portals starting in the camera's room
+bool boxVisibleInRoom(const RoomVisibility& visibility, int room, bool onBoundary, const float boxMin[3], const float boxMax[3]); //<<< box in room is inside one of its view volumes, only call for boxes inside the camera frustum
+
+#endif
@@ -0,0 +1,96 @@
+//Benchmark for the room/portal culling on level 1: random first person views, once in the spawn room
+//and once anywhere on the platform. For enemy sized boxes and for every wall it counts what the frustum keeps,
+//what the portals keep and what is really visible, found by marching rays against the wall columns.
+//"missed" are boxes the portals dropped although a ray reaches them, it has to stay 0.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "benchutil.hpp"
+#include "simulation.hpp"
+
+struct Counts {
+    int frustum = 0, portals = 0, visible = 0, missed = 0;
+};
+
+static void count(Counts& counts, bool inFrustum, bool throughPortals, bool visible) {
+    counts.frustum += inFrustum;
+    counts.portals += inFrustum && throughPortals;
+    counts.visible += visible;
+    counts.missed += visible && !(inFrustum && throughPortals);
+}
+
+int main() {
+    GameState game;
+    startGame(game, 1, 1, 0.0);
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), 2560.0f / 1440.0f, 0.1f, 100.0f);
+    const int views = 200;
+
+    printf("%d rooms, %d walls, %d views per row\n", (int)game.rooms.rooms.size() - 1, (int)game.walls.size(), views);
+    printf("%-12s %-8s %8s %8s %8s %8s %10s\n", "eye", "boxes", "frustum", "portals", "visible", "missed", "us/view");
+    for (int row = 0; row < 2; ++row) {
+        std::srand(3);
+        Counts low, walls;
+        RoomVisibility visibility;
+        double seconds = 0.0;
+        for (int v = 0; v < views; ++v) {
+            glm::vec3 eye;
+            do {
+                eye = row == 0 ? glm::vec3(randomRange(-8.0f, 8.0f), 2.0f, randomRange(-58.0f, -42.0f))
+                               : glm::vec3(randomRange(-59.0f, 59.0f), 2.0f, randomRange(-59.0f, 59.0f));
+            } while (wallAtPoint(game.wallGrid, game.walls, eye.x, eye.z) >= 0);
+            float yaw = randomRange(0.0f, 6.283f);
+            glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(sin(yaw), 0.0f, -cos(yaw)), glm::vec3(0.0f, 1.0f, 0.0f));
+            Frustum frustum = extractFrustum(glm::value_ptr(projection * view));
+            const float eyePosition[3] = { eye.x, eye.y, eye.z };
+
+            auto start = std::chrono::steady_clock::now();
+            findVisibleRooms(game.rooms, frustum, eyePosition, visibility);
+            seconds += secondsSince(start);
+
+            //enemy sized boxes anywhere on the platform
+            for (int k = 0; k < 100; ++k) {
+                glm::vec3 center(randomRange(-59.0f, 59.0f), 0.5f, randomRange(-59.0f, 59.0f));
+                if (wallAtPoint(game.wallGrid, game.walls, center.x, center.z) >= 0) continue;
+                const float boxMin[3] = { center.x - 0.5f, 0.0f, center.z - 0.5f };
+                const float boxMax[3] = { center.x + 0.5f, 1.0f, center.z + 0.5f };
+                bool onBoundary;
+                int room = roomOfPoint(game.rooms, center.x, center.z, onBoundary);
+                bool visible = false;
+                for (int s = 0; s < 40 && !visible; ++s) {
+                    glm::vec3 p(randomRange(boxMin[0], boxMax[0]), randomRange(0.0f, 1.0f), randomRange(boxMin[2], boxMax[2]));
+                    visible = pointInFrustum(frustum, p) && !rayBlocked(game.walls, game.wallGrid, eye, p, -1);
+                }
+                count(low, boxVisible(frustum, boxMin, boxMax), boxVisibleInRoom(visibility, room, onBoundary, boxMin, boxMax), visible);
+            }
+
+            //every wall, rays aim at points just outside its faces
+            for (int i = 0; i < (int)game.walls.size(); ++i) {
+                const wall& w = game.walls[i];
+                const float boxMin[3] = { w.x - 0.5f, 0.0f, w.z - 0.5f };
+                const float boxMax[3] = { w.x + 0.5f, w.h, w.z + 0.5f };
+                bool onBoundary;
+                int room = roomOfPoint(game.rooms, w.x, w.z, onBoundary);
+                bool visible = false;
+                for (int s = 0; s < 40 && !visible; ++s) {
+                    float along = randomRange(-0.5f, 0.5f), y = randomRange(0.0f, w.h);
+                    glm::vec3 faces[5] = { { w.x + 0.501f, y, w.z + along }, { w.x - 0.501f, y, w.z + along },
+                                           { w.x + along, y, w.z + 0.501f }, { w.x + along, y, w.z - 0.501f },
+                                           { w.x + along, w.h + 0.001f, w.z + randomRange(-0.5f, 0.5f) } };
+                    glm::vec3 p = faces[std::rand() % 5];
+                    visible = pointInFrustum(frustum, p) && !rayBlocked(game.walls, game.wallGrid, eye, p, i);
+                }
+                count(walls, boxVisible(frustum, boxMin, boxMax), boxVisibleInRoom(visibility, room, room != 0, boxMin, boxMax), visible);
+            }
+        }
+        const char* eyeName = row == 0 ? "spawn room" : "anywhere";
+        printf("%-12s %-8s %8d %8d %8d %8d %10.1f\n", eyeName, "enemy", low.frustum, low.portals, low.visible, low.missed, seconds * 1e6 / views);
+        printf("%-12s %-8s %8d %8d %8d %8d\n", eyeName, "wall", walls.frustum, walls.portals, walls.visible, walls.missed);
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+//Startup time of the shaders with and without the program binary cache, without showing a window.
+//Builds every scene shader variant and the culling compute shader (if GL 4.3 is there) twice in fresh
+//contexts: cold with an empty cache directory, warm with the binaries the cold run stored.
+//Mesa keeps its own shader cache on disk and offers no binary format without it, so point it at an empty
+//directory instead of turning it off, then the cold run really compiles:
+//    MESA_SHADER_CACHE_DIR=$(mktemp -d) ./shader_cache_bench     (from the playground directory, it loads the shaders from there)
+#include <GL/glew.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <common/shader.hpp>
+
+#include "hiddencontext.hpp"
+
+const char* cacheDirectory = "shadercache_bench";
+
+//one start of the game's shader setup in a new context, returns false without a context
+static bool buildShaders(const char* run, bool compute) {
+    GLFWwindow* window = createHiddenContext(compute ? 4 : 3, 3, "shader_cache_bench", 64, 64);
+    if (!window) {
+        return false;
+    }
+
+    ShaderCacheStats before = GetShaderCacheStats();
+    ShaderVariants variants;
+    variants.vertex_file_path = "SimpleVertexShader.vertexshader";
+    variants.fragment_file_path = "SimpleFragmentShader.fragmentshader";
+    variants.features = { "LIT", "FOG" };
+    for (unsigned int bits = 0; bits < 4; ++bits) {
+        GetShaderVariant(variants, bits);
+    }
+    ShaderProgram culling;
+    if (compute) {
+        culling = LoadComputeShader("FrustumCull.computeshader");
+    }
+    glFinish();
+    ShaderCacheStats after = GetShaderCacheStats();
+
+    printf("\n%-5s %10.2f ms  %d from the cache, %d compiled, %d rejected\n\n", run, (after.seconds - before.seconds) * 1000.0,
+           after.hits - before.hits, after.compiled - before.compiled, after.rejected - before.rejected);
+    DeleteShaderVariants(variants);
+    glDeleteProgram(culling.id);
+    glfwDestroyWindow(window);
+    return true;
+}
+
+int main() {
+    if (!glfwInit()) {
+        printf("no GLFW\n");
+        return 1;
+    }
+    //the 4.3 context also covers the compute shader, a 3.3 one is enough for the rest
+    bool compute = true;
+    GLFWwindow* probe = createHiddenContext(4, 3, "shader_cache_bench", 64, 64);
+    if (probe) {
+        glfwDestroyWindow(probe);
+    } else {
+        compute = false;
+    }
+
+    //empty cache for the cold run, the directory is only used by this bench
+    SetShaderCacheDirectory(cacheDirectory);
+    std::string clear = std::string("rm -f ") + cacheDirectory + "/*.bin";
+#ifdef _WIN32
+    clear = std::string("del /q ") + cacheDirectory + "\\*.bin";
+#endif
+    if (std::system(clear.c_str()) != 0) {
+        printf("could not clear %s\n", cacheDirectory);
+    }
+
+    if (!buildShaders("cold", compute) || !buildShaders("warm", compute)) {
+        printf("no GL %s context\n", compute ? "4.3" : "3.3");
+        glfwTerminate();
+        return 1;
+    }
+    ShaderCacheStats stats = GetShaderCacheStats();
+    glfwTerminate();
+    if (stats.hits == 0) {
+        printf("the driver offers no program binary formats, nothing was cached\n");
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+//Fragment cost of every scene shader variant, without showing a window. Every variant shades full screen
+//quads of the lit cube color, nothing else runs, so the time per fragment is what the variant costs.
+//Meant for Mesa's llvmpipe, where the fragment shader runs on the CPU:
+//    LIBGL_ALWAYS_SOFTWARE=1 ./shader_variants_bench     (from the playground directory, it loads the shaders from there)
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <common/shader.hpp>
+
+#include "hiddencontext.hpp"
+
+const int width = 1280, height = 720;
+const int layers = 40;                              //full screen quads per measurement
+
+//FrameBlock and LightBlock of playground.cpp
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float fogDensity;
+};
+
+struct LightBlock {
+    glm::vec3 lightPos;
+    float ambientStrength;
+    float specularStrength;
+    float shininess;
+    float lightIntensity;
+    float padding;
+    glm::vec3 spotPosition;
+    float innerCone;
+    glm::vec3 spotDirection;
+    float outerCone;
+    glm::vec4 diffuse, specular, ambient;
+};
+
+static double millisecondsPerLayer(GLuint program, GLuint vao) {
+    glUseProgram(program);
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, 1);   //warm up, the driver may finish compiling here
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, layers);
+    glFinish();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / layers;
+}
+
+int main() {
+    if (!glfwInit()) {
+        printf("no GLFW\n");
+        return 1;
+    }
+    if (!createHiddenContext(3, 3, "shader_variants_bench", width, height)) {
+        printf("no GL 3.3 context\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwSwapInterval(0);
+    printf("%s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+    //one quad over the whole screen, identity view and projection, instances all on top of each other
+    const float vertices[] = { -1.0f, -1.0f, 0.0f,  0.0f, 0.0f, 1.0f,    1.0f, -1.0f, 0.0f,  0.0f, 0.0f, 1.0f,
+                                1.0f,  1.0f, 0.0f,  0.0f, 0.0f, 1.0f,   -1.0f,  1.0f, 0.0f,  0.0f, 0.0f, 1.0f };
+    const unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+    const float instance[11] = { 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.4f, 0.4f, 0.4f, 1.0f };
+    std::vector<float> instanceData;
+    for (int i = 0; i < layers; ++i) {
+        instanceData.insert(instanceData.end(), instance, instance + 11);
+    }
+    GLuint vao, buffers[3];
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(3, buffers);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[2]);
+    glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(float), instanceData.data(), GL_STATIC_DRAW);
+    const int offsets[3] = { 0, 4, 7 }, sizes[3] = { 4, 3, 4 };
+    for (int i = 0; i < 3; ++i) {
+        glVertexAttribPointer(2 + i, sizes[i], GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(offsets[i] * sizeof(float)));
+        glEnableVertexAttribArray(2 + i);
+        glVertexAttribDivisor(2 + i, 1);
+    }
+
+    FrameBlock frame = { glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 2.0f), 0.05f };
+    LightBlock light = {};
+    light.lightPos = glm::vec3(0.0f, 0.0f, 5.0f);
+    light.lightIntensity = 1.0f;
+    light.spotPosition = glm::vec3(0.0f, 0.0f, 1.0f);
+    light.spotDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+    light.innerCone = 0.976f;
+    light.outerCone = 0.861f;
+    light.diffuse = light.specular = glm::vec4(1.0f);
+    GLuint blocks[2];
+    glGenBuffers(2, blocks);
+    glBindBuffer(GL_UNIFORM_BUFFER, blocks[0]);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(frame), &frame, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, blocks[0]);
+    glBindBuffer(GL_UNIFORM_BUFFER, blocks[1]);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(light), &light, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 1, blocks[1]);
+
+    ShaderVariants variants;
+    variants.vertex_file_path = "SimpleVertexShader.vertexshader";
+    variants.fragment_file_path = "SimpleFragmentShader.fragmentshader";
+    variants.features = { "LIT", "FOG" };
+    const unsigned int measured[4] = { 0, 1, 2, 3 };
+    double times[4];
+    for (int v = 0; v < 4; ++v) {
+        ShaderProgram& program = GetShaderVariant(variants, measured[v]);
+        BindUniformBlock(program, "FrameData", 0);
+        BindUniformBlock(program, "LightData", 1);
+    }
+    glDisable(GL_DEPTH_TEST);
+    glViewport(0, 0, width, height);
+    for (int round = 0; round < 2; ++round) {       //the first round warms up caches and the driver
+        for (int v = 0; v < 4; ++v) {
+            times[v] = millisecondsPerLayer(variants.programs[measured[v]].id, vao);
+        }
+    }
+
+    printf("\n%d x %d, %d full screen layers per variant\n", width, height, layers);
+    printf("%-12s %12s %14s %10s\n", "variant", "ms/layer", "ns/fragment", "vs flat");
+    for (int v = 0; v < 4; ++v) {
+        std::string name;
+        for (size_t f = 0; f < variants.features.size(); ++f) {
+            if (measured[v] & (1u << f)) {
+                name += (name.empty() ? "" : "+") + variants.features[f];
+            }
+        }
+        printf("%-12s %12.3f %14.2f %9.2fx\n", name.empty() ? "flat" : name.c_str(), times[v], times[v] * 1e6 / (width * height), times[v] / times[0]);
+    }
+
+    DeleteShaderVariants(variants);
+    glfwTerminate();
+    return glGetError() == GL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <chrono>
+
+#include "profiler.hpp"
+#include "simthread.hpp"
+
+void takeSnapshot(const GameState& game, GameSnapshot& snapshot) {
+    snapshot.player = game.player;
+    snapshot.enemies.assign(game.enemies.begin(), game.enemies.end());
+    const BulletPool& bullets = game.bullets;
+    snapshot.bulletX.assign(bullets.x.begin(), bullets.x.begin() + bullets.count);
+    snapshot.bulletZ.assign(bullets.z.begin(), bullets.z.begin() + bullets.count);
+    snapshot.bulletPrevX.assign(bullets.prevX.begin(), bullets.prevX.begin() + bullets.count);
+    snapshot.bulletPrevZ.assign(bullets.prevZ.begin(), bullets.prevZ.begin() + bullets.count);
+    snapshot.cameraYaw = game.cameraYaw;
+    snapshot.prevCameraYaw = game.prevCameraYaw;
+    snapshot.isPlayerAlive = game.isPlayerAlive;
+    snapshot.isGameOver = isGameOver(game);
+    snapshot.time = game.time;
+    snapshot.ai = game.ai.stats;
+}
+
+uint32_t packInput(const TickInput& input) {
+    return input.turnLeft | input.turnRight << 1 | input.forward << 2 | input.backward << 3 |
+           input.lookLeft << 4 | input.lookRight << 5 | input.shoot << 6;
+}
+
+TickInput unpackInput(uint32_t bits) {
+    TickInput input;
+    input.turnLeft = (bits & 1) != 0;
+    input.turnRight = (bits & 2) != 0;
+    input.forward = (bits & 4) != 0;
+    input.backward = (bits & 8) != 0;
+    input.lookLeft = (bits & 16) != 0;
+    input.lookRight = (bits & 32) != 0;
+    input.shoot = (bits & 64) != 0;
+    return input;
+}
+
+double simThreadClock() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//fixed updates on the thread's own clock, sleeps in between and publishes every update
+static void simLoop(SimThread& sim, GameState& game) {
+    PROFILE_THREAD("simulation");
+    const double tickLength = 1.0 / tickRate;
+    double nextTick = simThreadClock() + tickLength;
+    uint64_t tick = 0;
+    while (!sim.quit.load(std::memory_order_relaxed)) {
+        double now = simThreadClock();
+        if (now < nextTick) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(nextTick - now));
+            continue;
+        }
+        //after a stall the game continues from now instead of running hundreds of updates at once
+        if (now - nextTick > sim.maxCatchUp) {
+            sim.ticksDropped += (int)((now - nextTick) / tickLength);
+            nextTick = now;
+        }
+        nextTick += tickLength;
+
+        uint64_t input = sim.input.load(std::memory_order_acquire);
+        simulateTick(game, unpackInput((uint32_t)input));
+
+        GameSnapshot& snapshot = writeSlot(sim.snapshots);
+        takeSnapshot(game, snapshot);
+        snapshot.tick = ++tick;
+        snapshot.publishedAt = simThreadClock();
+        snapshot.inputSequence = (uint32_t)(input >> 32);
+        publish(sim.snapshots);
+        if (snapshot.isGameOver) {
+            return;
+        }
+    }
+}
+
+void startSimThread(SimThread& sim, GameState& game) {
+    sim.quit = false;
+    sim.ticksDropped = 0;
+    GameSnapshot& first = writeSlot(sim.snapshots);
+    takeSnapshot(game, first);
+    first.tick = 0;
+    first.publishedAt = simThreadClock();
+    first.inputSequence = (uint32_t)(sim.input.load() >> 32);
+    publish(sim.snapshots);
+    sim.thread = std::thread(simLoop, std::ref(sim), std::ref(game));
+}
+
+void stopSimThread(SimThread& sim) {
+    sim.quit = true;
+    if (sim.thread.joinable()) {
+        sim.thread.join();
+    }
+}
+
+void sendInput(SimThread& sim, const TickInput& input, uint32_t sequence) {
+    sim.input.store((uint64_t)sequence << 32 | packInput(input), std::memory_order_release);
+}
+
+uint32_t inputChanged(InputLatency& latency, double sampledAt) {
+    //a change that was not shown yet is replaced, only the newest one is measured
+    latency.pendingSequence = ++latency.lastSequence;
+    latency.pendingSince = sampledAt;
+    return latency.pendingSequence;
+}
+
+void framePresented(InputLatency& latency, const GameSnapshot& shown, double presentedAt) {
+    if (latency.pendingSequence == 0 || shown.inputSequence < latency.pendingSequence) {
+        return;
+    }
+    double seconds = presentedAt - latency.pendingSince;
+    latency.samples++;
+    latency.total += seconds;
+    latency.worst = std::max(latency.worst, seconds);
+    latency.pendingSequence = 0;
+}
@@ -0,0 +1,98 @@
+#ifndef SIMTHREAD_HPP
+#define SIMTHREAD_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "simulation.hpp"
+
+//The simulation on its own thread: it runs the fixed updates on its own clock and publishes a snapshot after every one,
+//the render thread draws the newest snapshot it finds. Neither waits for the other, they only meet in atomics.
+
+//Three slots: the writer fills its back slot, the reader reads its front slot, and publishing or taking swaps
+//with the shared middle one. Lock free and wait free for one writer and one reader.
+template <typename T>
+struct TripleBuffer {
+    static const int fresh = 4;                     //set in middle while it holds a slot the reader has not taken
+    T slots[3];
+    std::atomic<int> middle{ 1 };
+    int back = 0;                                   //only touched by the writer
+    int front = 2;                                  //only touched by the reader
+};
+
+template <typename T>
+T& writeSlot(TripleBuffer<T>& buffer) {
+    return buffer.slots[buffer.back];
+}
+
+//hands the back slot to the reader, the writer continues with the slot that was in the middle
+template <typename T>
+void publish(TripleBuffer<T>& buffer) {
+    buffer.back = buffer.middle.exchange(buffer.back | TripleBuffer<T>::fresh, std::memory_order_acq_rel) & 3;
+}
+
+//false if nothing was published since the last call, the front slot stays what it was then
+template <typename T>
+bool takeLatest(TripleBuffer<T>& buffer) {
+    if (!(buffer.middle.load(std::memory_order_relaxed) & TripleBuffer<T>::fresh)) {
+        return false;
+    }
+    buffer.front = buffer.middle.exchange(buffer.front, std::memory_order_acq_rel) & 3;
+    return true;
+}
+
+template <typename T>
+const T& readSlot(const TripleBuffer<T>& buffer) {
+    return buffer.slots[buffer.front];
+}
+
+//what rendering needs of one update, previous and current state so it can interpolate in between
+struct GameSnapshot {
+    cube player;
+    std::vector<cube> enemies;
+    std::vector<float> bulletX, bulletZ, bulletPrevX, bulletPrevZ;
+    float cameraYaw = 0.0f, prevCameraYaw = 0.0f;
+    bool isPlayerAlive = true;
+    bool isGameOver = false;
+    double time = 0.0;                              //GameState::time after the update, the cooldowns count from it
+    AiStats ai;
+    uint64_t tick = 0;
+    double publishedAt = 0.0;                       //simThreadClock when the update was done, interpolation starts from here
+    uint32_t inputSequence = 0;                     //the newest input change this update had applied
+};
+
+void takeSnapshot(const GameState& game, GameSnapshot& snapshot); //<<< copies into the vectors it already has, no allocation after the first few
+
+//a TickInput as bits, so it fits into one atomic with the sequence number of its change
+uint32_t packInput(const TickInput& input);
+TickInput unpackInput(uint32_t bits);
+
+struct SimThread {
+    std::thread thread;
+    std::atomic<bool> quit{ false };
+    std::atomic<uint64_t> input{ 0 };               //sequence << 32 | packInput, written by the render thread
+    TripleBuffer<GameSnapshot> snapshots;
+    std::atomic<int> ticksDropped{ 0 };             //updates skipped after a stall longer than maxCatchUp
+    double maxCatchUp = 0.25;                       //same limit as the frame time cut of the single threaded loop
+};
+
+double simThreadClock(); //<<< seconds on a steady clock, the same for both threads
+void startSimThread(SimThread& sim, GameState& game); //<<< game belongs to the thread until stopSimThread, the first snapshot is published before this returns
+void stopSimThread(SimThread& sim); //<<< also returns after the thread ended by itself at the end of the game
+void sendInput(SimThread& sim, const TickInput& input, uint32_t sequence); //<<< the next update uses it, sequence should grow with every change
+
+//time from sampling an input change to the end of the swap that shows its first update
+struct InputLatency {
+    uint32_t pendingSequence = 0;                   //change that was sent but not shown yet, 0 if none
+    double pendingSince = 0.0;
+    uint32_t lastSequence = 0;
+    int samples = 0;
+    double total = 0.0, worst = 0.0;                //seconds since the last reset
+};
+
+uint32_t inputChanged(InputLatency& latency, double sampledAt); //<<< returns the sequence number for sendInput
+void framePresented(InputLatency& latency, const GameSnapshot& shown, double presentedAt); //<<< call right after the swap
+
+#endif
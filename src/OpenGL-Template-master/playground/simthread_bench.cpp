@@ -0,0 +1,164 @@
+//Benchmark for the simulation thread, no window needed.
+//First a writer and a reader hammer a TripleBuffer and the reader checks that no slot it gets is torn.
+//Then level 1 runs with a fake renderer that spends a fixed time per frame, once single threaded like the
+//old game loop and once with the simulation on its own thread, and both report the input latency:
+//time from sampling an input change until the end of the frame that shows its first update.
+//usage: simthread_bench [render ms per frame] [seconds]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "simthread.hpp"
+
+struct Filled {
+    std::vector<uint64_t> values = std::vector<uint64_t>(4096);
+};
+
+static int tornSnapshots(double seconds, long long& published, long long& taken) {
+    TripleBuffer<Filled> buffer;
+    std::atomic<bool> done(false);
+    published = 0;
+    std::thread writer([&]() {
+        uint64_t value = 1;
+        while (!done) {
+            Filled& slot = writeSlot(buffer);
+            std::fill(slot.values.begin(), slot.values.end(), value++);
+            publish(buffer);
+        }
+        published = (long long)value - 1;
+    });
+
+    int torn = 0;
+    taken = 0;
+    uint64_t last = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        if (!takeLatest(buffer)) {
+            continue;
+        }
+        const Filled& slot = readSlot(buffer);
+        taken++;
+        uint64_t first = slot.values[0];
+        bool same = std::all_of(slot.values.begin(), slot.values.end(), [first](uint64_t v) { return v == first; });
+        torn += !same || first <= last;             //every slot has to be complete and newer than the one before
+        last = first;
+    }
+    done = true;
+    writer.join();
+    return torn;
+}
+
+//a player that presses and releases keys, changes every 100 ms
+static TickInput scriptedInput(double time) {
+    TickInput input;
+    int phase = (int)(time * 10.0) % 4;
+    input.forward = phase == 0 || phase == 1;
+    input.turnLeft = phase == 1;
+    input.turnRight = phase == 3;
+    return input;
+}
+
+static void busyFor(double seconds) {
+    double end = simThreadClock() + seconds;
+    while (simThreadClock() < end) {
+    }
+}
+
+struct LoopResult {
+    int frames = 0;
+    long long ticks = 0;
+    InputLatency latency;
+};
+
+//the old loop: input, the updates that are due, then render, all on one thread
+static LoopResult runSingleThreaded(double renderSeconds, double seconds) {
+    LoopResult result;
+    GameState game;
+    startGame(game, 1, 1, 0.0);
+    const double tickLength = 1.0 / tickRate;
+    double start = simThreadClock(), lastTime = start, accumulator = 0.0;
+    uint32_t inputBits = packInput(TickInput());
+    GameSnapshot shown;
+    while (simThreadClock() - start < seconds && !isGameOver(game)) {
+        double now = simThreadClock();
+        accumulator += std::min(now - lastTime, 0.25);
+        lastTime = now;
+        TickInput input = scriptedInput(now - start);
+        if (packInput(input) != inputBits) {
+            inputBits = packInput(input);
+            inputChanged(result.latency, now);
+        }
+        while (accumulator >= tickLength) {
+            simulateTick(game, input);
+            accumulator -= tickLength;
+            result.ticks++;
+            shown.inputSequence = result.latency.lastSequence;
+        }
+        busyFor(renderSeconds);
+        framePresented(result.latency, shown, simThreadClock());
+        result.frames++;
+    }
+    return result;
+}
+
+static LoopResult runPipelined(double renderSeconds, double seconds) {
+    LoopResult result;
+    GameState game;
+    startGame(game, 1, 1, 0.0);
+    SimThread sim;
+    uint32_t inputBits = packInput(TickInput()), inputSequence = 0;
+    sendInput(sim, TickInput(), 0);
+    startSimThread(sim, game);
+    double start = simThreadClock();
+    while (simThreadClock() - start < seconds) {
+        takeLatest(sim.snapshots);
+        const GameSnapshot& snapshot = readSlot(sim.snapshots);
+        if (snapshot.isGameOver) {
+            break;
+        }
+        TickInput input = scriptedInput(simThreadClock() - start);
+        if (packInput(input) != inputBits) {
+            inputBits = packInput(input);
+            inputSequence = inputChanged(result.latency, simThreadClock());
+        }
+        sendInput(sim, input, inputSequence);
+        busyFor(renderSeconds);
+        framePresented(result.latency, snapshot, simThreadClock());
+        result.frames++;
+        result.ticks = (long long)snapshot.tick;
+    }
+    stopSimThread(sim);
+    return result;
+}
+
+static double averageLatency(const LoopResult& r) {
+    return r.latency.samples ? r.latency.total / r.latency.samples : 0.0;
+}
+
+static void printLoop(const char* name, const LoopResult& r, double seconds) {
+    printf("%-16s %8.1f %8.1f %12.2f %12.2f %8d\n", name, r.frames / seconds, r.ticks / seconds, averageLatency(r) * 1000.0,
+           r.latency.worst * 1000.0, r.latency.samples);
+}
+
+int main(int argc, char** argv) {
+    double renderMs = argc > 1 ? std::atof(argv[1]) : 12.0;
+    double seconds = argc > 2 ? std::atof(argv[2]) : 5.0;
+
+    long long published, taken;
+    int torn = tornSnapshots(1.0, published, taken);
+    printf("triple buffer: %lld published, %lld taken, %d torn or out of order\n\n", published, taken, torn);
+
+    printf("render %.1f ms per frame, %.0f s per loop\n", renderMs, seconds);
+    printf("%-16s %8s %8s %12s %12s %8s\n", "", "frames/s", "ticks/s", "latency avg", "latency max", "changes");
+    LoopResult single = runSingleThreaded(renderMs / 1000.0, seconds);
+    LoopResult pipelined = runPipelined(renderMs / 1000.0, seconds);
+    printLoop("single thread", single, seconds);
+    printLoop("sim thread", pipelined, seconds);
+    //the updates run behind the frame that draws them, which is the price of not waiting for each other
+    double added = averageLatency(pipelined) - averageLatency(single);
+    printf("the sim thread adds %.2f ms of average latency, %.2f frames of %.1f ms\n", added * 1000.0, added / (renderMs / 1000.0), renderMs);
+    return torn == 0 ? 0 : 1;
+}
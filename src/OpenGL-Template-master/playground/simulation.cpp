@@ -0,0 +1,542 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tuple>
+
+#include <glm/glm.hpp>
+
+#include "profiler.hpp"
+#include "simulation.hpp"
+
+static const float maxHeight = 5.0f;                //height of the spawn room walls
+
+//---------------------------------------------------Game setup and update---------------------------------------------------//
+void startGame(GameState& game, int level, uint64_t seed, double startTime) {
+    //these methods should be placed in the while loop if there were more levels
+    game.rng = seedRng(seed);
+    game.player = { 0.0f, -50.0f, 180.0f, 0.1f, 0.0f };
+    game.enemies = distributeEnemies(level, game.rng);
+    game.walls = generatelevel(maxHeight, level, game.rng, game.rooms);
+    game.wallGrid = buildWallGrid(game.walls);      //walls don't move after this, so the grid is built only once
+    initFlowField(game.chase, game.wallGrid, game.platformSize);
+    clearOccupancy(game.crowd, game.chase);
+    initBulletPool(game.bullets, maxBullets);
+    game.cameraYaw = 0.0f;
+    game.prevCameraYaw = 0.0f;
+    game.isPlayerAlive = true;
+    game.time = startTime;
+    game.ai.tick = 0;
+    game.ai.tracked = -1;
+    game.ai.stats = AiStats();
+    staggerEnemyThinking(game.enemies);
+
+    storePreviousState(game.player);
+    for (cube& enemy : game.enemies) {
+        storePreviousState(enemy);
+    }
+}
+
+//one fixed simulation step, the clock advances by exactly 1 / tickRate per call
+void simulateTick(GameState& game, const TickInput& input) {
+    PROFILE_SCOPE("simulateTick");
+    game.time += 1.0 / tickRate;
+    float currentTime = (float)game.time;
+
+    storePreviousState(game.player);
+    for (cube& enemy : game.enemies) {
+        storePreviousState(enemy);
+    }
+    game.prevCameraYaw = game.cameraYaw;
+
+    {
+        PROFILE_SCOPE("applyInput");
+        applyInput(game, input, currentTime);
+    }
+    {
+        PROFILE_SCOPE("updateBullets");
+        updateBullets(game.bullets, game.walls, game.wallGrid, game.platformSize, game.enemies, game.player, game.isPlayerAlive);
+    }
+    {
+        PROFILE_SCOPE("collideWithWalls");
+        collideWithWalls(game.player, game.walls, game.wallGrid, game.platformSize);
+    }
+    {
+        PROFILE_SCOPE("moveEnemies");
+        updateFlowField(game.chase, game.player.x, game.player.z);
+        moveEnemies(game.enemies, game.player, game.chase, game.crowd, game.walls, game.wallGrid, game.platformSize);
+    }
+    {
+        PROFILE_SCOPE("thinkEnemies");
+        thinkEnemies(game.ai, game.enemies, game.player, game.cameraYaw, game.bullets, game.wallGrid, currentTime);
+    }
+}
+
+bool isGameOver(const GameState& game) {
+    return !game.isPlayerAlive || game.enemies.empty();
+}
+
+//moves the player as the input says
+void applyInput(GameState& game, const TickInput& input, float currentTime) {
+    cube& player = game.player;
+
+    if (input.turnLeft)                                     //rotates playercube to the left
+        player.rotation -= 1.0f;
+    if (input.turnRight)                                    //rotates playercube to the right
+        player.rotation += 1.0f;
+    if (input.forward) {                                    //move forward
+        player.x += player.speed * sin(glm::radians(player.rotation));//calculates how the player has to move forward
+        player.z -= player.speed * cos(glm::radians(player.rotation));
+    }
+    if (input.backward) {                                   //move backwards
+        player.x -= player.speed * sin(glm::radians(player.rotation));//calculates how the player has to move backwards
+        player.z += player.speed * cos(glm::radians(player.rotation));
+    }
+
+    if (input.lookLeft) {                                   //turns view to the left
+        game.cameraYaw -= 1.0f;
+    }
+    if (input.lookRight) {                                  //turns view to the right
+        game.cameraYaw += 1.0f;
+    }
+
+    if (input.shoot && (currentTime - player.lastShotTime) > player.shootCooldown) {   //shoot bullet
+        float shootAngle = player.rotation + game.cameraYaw;                        //calculates at which angle the bullet should be shot
+        spawnBullet(game.bullets, player.x, player.z, shootAngle, bulletSpeed, 1, false);
+        player.lastShotTime = currentTime;
+    }
+}
+
+//---------------------------------------------------Collsision Methods---------------------------------------------------//
+void updateBullets(BulletPool& bullets, const std::vector<wall>& walls, const WallGrid& wallGrid, float platformSize, std::vector<cube>& enemies, cube player, bool& isPlayerAlive) {
+    float border = platformSize / 2.0f;
+    float bulletSize = 0.2f;
+    float cSize = 0.5f;
+
+    moveBullets(bullets);
+
+    //removed bullets are replaced by the last one, so i only advances if bullet i stays
+    int i = 0;
+    while (i < bullets.count) {
+        bool bounced = bounceBullet(bullets, i, walls, wallGrid, border);
+        bool remove = false;
+
+        //checks player bullet collision
+        if (!bullets.enemy[i]) {
+            for (int j = 0; j < (int)enemies.size(); ++j) {
+                float distanceX = bullets.x[i] - enemies[j].x;
+                float distanceZ = bullets.z[i] - enemies[j].z;
+                float distance = sqrt(distanceX * distanceX + distanceZ * distanceZ);
+
+                if (distance < (bulletSize + cSize)) {
+                    enemies.erase(enemies.begin() + j);
+                    remove = true;
+                    break;
+                }
+            }
+        }
+
+        //checks enemy bullet collision
+        if (bullets.enemy[i]) {
+            float distanceToPlayerX = bullets.x[i] - player.x;
+            float distanceToPlayerZ = bullets.z[i] - player.z;
+            float distanceToPlayer = sqrt(distanceToPlayerX * distanceToPlayerX + distanceToPlayerZ * distanceToPlayerZ);
+
+            if (distanceToPlayer < (bulletSize + 0.5f)) {
+                isPlayerAlive = false;
+                remove = true;
+            }
+        }
+
+        if (bounced) {
+            if (bullets.bounce[i] > 0) {
+                bullets.bounce[i]--;
+            }
+            else {
+                remove = true;
+            }
+        }
+
+        if (remove) {
+            removeBullet(bullets, i);
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+//keeps a tank (the tank or an enemy) on the platform and pushes it out of the walls
+void collideWithWalls(cube& tank, const std::vector<wall>& walls, const WallGrid& wallGrid, float platformSize) {
+    float border = platformSize / 2.0f;     //is halved because the border is from -60 to 60 and not from 0 to 120
+    float tankSize = 0.5f;
+    float wallSize = 0.5f;
+
+    if (tank.x <= -border + 0.5f) tank.x = -border + 0.5f;
+
+    if (tank.x >= border - 0.5f)  tank.x = border - 0.5f;
+
+
+
+    if (tank.z <= -border + 0.5f) tank.z = -border + 0.5f;
+
+    if (tank.z >= border - 0.5f)  tank.z = border - 0.5f;
+
+    //pushes move the tank less than a cell so walls two cells away are enough
+    int nearby[25];
+    int nearbyCount = wallsNear(wallGrid, tank.x, tank.z, 2, nearby, 25);
+    for (int n = 0; n < nearbyCount; ++n) {
+        const wall& w = walls[nearby[n]];
+        bool collisionX = tank.x + tankSize > w.x - wallSize && tank.x - tankSize < w.x + wallSize;
+        bool collisionZ = tank.z + tankSize > w.z - wallSize && tank.z - tankSize < w.z + wallSize;
+
+        if (collisionX && collisionZ) {
+            
+            float overlapX = (tankSize + wallSize) - std::abs(tank.x - w.x);
+            float overlapZ = (tankSize + wallSize) - std::abs(tank.z - w.z);
+
+            if (overlapX < overlapZ) {
+  
+                if (tank.x < w.x) {
+                    tank.x -= overlapX; 
+                }
+                else {
+                    tank.x += overlapX; 
+                }
+            }
+            else {
+
+                if (tank.z < w.z) {
+                    tank.z -= overlapZ; 
+                }
+                else {
+                    tank.z += overlapZ; 
+                }
+            }
+        }
+    }
+}
+
+//every enemy drives at its speed toward the center of the next cell of the flow field, walls push it back like the player.
+//It doesn't drive into a cell another enemy stands in but waits behind it, so the enemies queue up along the field
+//instead of collapsing onto the same cell centers
+void moveEnemies(std::vector<cube>& enemies, const cube& player, const FlowField& chase, FlowOccupancy& crowd, const std::vector<wall>& walls, const WallGrid& wallGrid, float platformSize) {
+    clearOccupancy(crowd, chase);
+    for (int i = 0; i < (int)enemies.size(); ++i) {
+        int cell = flowCell(chase, enemies[i].x, enemies[i].z);
+        if (cell >= 0) {
+            occupyCell(crowd, cell, i);
+        }
+    }
+
+    for (int i = 0; i < (int)enemies.size(); ++i) {
+        cube& enemy = enemies[i];
+        float toPlayerX = player.x - enemy.x;
+        float toPlayerZ = player.z - enemy.z;
+        if (toPlayerX * toPlayerX + toPlayerZ * toPlayerZ < chaseStopDistance * chaseStopDistance) {
+            continue;
+        }
+        float nextX, nextZ;
+        if (!flowStep(chase, enemy.x, enemy.z, nextX, nextZ)) {
+            continue;
+        }
+        float deltaX = nextX - enemy.x;
+        float deltaZ = nextZ - enemy.z;
+        float length = sqrt(deltaX * deltaX + deltaZ * deltaZ);
+        if (length <= 0.0f) {
+            continue;
+        }
+        float step = std::min(enemy.speed, length);
+        float movedX = enemy.x + deltaX / length * step;
+        float movedZ = enemy.z + deltaZ / length * step;
+        //the walls may push the enemy into another cell than the one it drove toward, so the cell is only claimed
+        //where it ends up, and the move is undone if another enemy holds that one
+        float oldX = enemy.x, oldZ = enemy.z;
+        int from = flowCell(chase, enemy.x, enemy.z);
+        enemy.x = movedX;
+        enemy.z = movedZ;
+        collideWithWalls(enemy, walls, wallGrid, platformSize);
+        int to = flowCell(chase, enemy.x, enemy.z);
+        if (to == from) {
+            continue;
+        }
+        if (to >= 0 && !occupyCell(crowd, to, i)) {
+            enemy.x = oldX;
+            enemy.z = oldZ;
+            continue;
+        }
+        if (from >= 0 && crowd.agent[from] == i) {
+            crowd.agent[from] = -1;
+        }
+    }
+}
+
+//---------------------------------------------------Methods to build structures---------------------------------------------------//
+bool hasLineOfSight(cube enemy, cube player, const WallGrid& wallGrid) {
+    //walks the cells between enemy and player and stops at the first wall
+    return !raycastWalls(wallGrid, enemy.x, enemy.z, player.x, player.z).hit;
+}
+
+//updates until the enemy thinks again: every one close to the player, then less often with the distance, least often out of view
+static int thinkInterval(float deltaX, float deltaZ, float viewX, float viewZ) {
+    float distance = sqrt(deltaX * deltaX + deltaZ * deltaZ);
+    if (distance < aiNearDistance) {
+        return 1;
+    }
+    bool onScreen = distance < aiViewDistance && deltaX * viewX + deltaZ * viewZ > distance * cos(glm::radians(aiViewHalfAngle));
+    return onScreen ? std::min(1 + (int)(distance / aiNearDistance), aiOffScreenInterval) : aiOffScreenInterval;
+}
+
+//rotates the enemy towards the player and shoots if it is reloaded and sees the player.
+//While reloading the line of sight doesn't matter, so it isn't tested
+static void thinkEnemy(cube& enemy, const cube& player, BulletPool& bullets, const WallGrid& wallGrid, float currentTime, AiStats& stats) {
+    float deltaX = player.x - enemy.x;
+    float deltaZ = player.z - enemy.z;
+    float angle = atan2(deltaX, -deltaZ);
+    enemy.rotation = glm::degrees(angle);
+    stats.thinks++;
+
+    if ((currentTime - enemy.lastShotTime) <= enemy.shootCooldown) {
+        stats.reloading++;
+        return;
+    }
+    stats.lineOfSightTests++;
+    if (hasLineOfSight(enemy, player, wallGrid)) {         //if the enemy has line of sight it shoots a bullet towards the players current location
+        spawnBullet(bullets, enemy.x, enemy.z, enemy.rotation, bulletSpeed, 1, true);
+        enemy.lastShotTime = currentTime;       //for checking if the last shot was at least 5 seconds ago (reload time)
+    }
+}
+
+//puts every enemy into the wheel slot it is due in, or at the end of its due list if that is now or earlier
+static void buildAiWheel(AiScheduler& ai, const std::vector<cube>& enemies) {
+    for (std::vector<int>& slot : ai.wheel) {
+        slot.clear();
+    }
+    ai.due[0].clear();
+    ai.due[1].clear();
+    ai.lastThoughtSum = 0;
+    for (int i = 0; i < (int)enemies.size(); ++i) {
+        int dueTick = enemies[i].lastThought + enemies[i].thinkInterval;
+        if (dueTick <= ai.tick) {
+            ai.due[enemies[i].thinkInterval == 1 ? 0 : 1].push_back(i);
+        }
+        else {
+            ai.wheel[dueTick % aiOffScreenInterval].push_back(i);
+        }
+        ai.lastThoughtSum += enemies[i].lastThought;
+    }
+    ai.tracked = (int)enemies.size();
+}
+
+void thinkEnemies(AiScheduler& ai, std::vector<cube>& enemies, const cube& player, float cameraYaw, BulletPool& bullets, const WallGrid& wallGrid, float currentTime) {
+    auto start = std::chrono::steady_clock::now();
+    AiStats& stats = ai.stats;
+    stats.thinks = stats.lineOfSightTests = stats.reloading = stats.deferred = 0;
+    ai.tick++;
+    float viewX = sin(glm::radians(player.rotation + cameraYaw));
+    float viewZ = -cos(glm::radians(player.rotation + cameraYaw));
+
+    //the enemies that became due join the end of the due lists in index order, behind the ones the last update left out.
+    //An interval is at most aiOffScreenInterval, so no enemy is due more than one turn of the wheel ahead
+    int count = (int)enemies.size();
+    if (ai.tracked != count) {
+        buildAiWheel(ai, enemies);
+    }
+    else {
+        std::vector<int>& slot = ai.wheel[ai.tick % aiOffScreenInterval];
+        std::sort(slot.begin(), slot.end());
+        for (int i : slot) {
+            ai.due[enemies[i].thinkInterval == 1 ? 0 : 1].push_back(i);
+        }
+        slot.clear();
+    }
+
+    //the enemies that think every update are close enough to hit the player, they get the budget first and the others
+    //what is left. The clock is only read every few thinks
+    bool overBudget = false;
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<int>& due = ai.due[pass];
+        size_t done = 0;
+        while (done < due.size() && !overBudget) {
+            int i = due[done++];
+            cube& enemy = enemies[i];
+            thinkEnemy(enemy, player, bullets, wallGrid, currentTime, stats);
+            ai.lastThoughtSum += ai.tick - enemy.lastThought;
+            enemy.lastThought = ai.tick;
+            enemy.thinkInterval = thinkInterval(player.x - enemy.x, player.z - enemy.z, viewX, viewZ);
+            ai.wheel[(ai.tick + enemy.thinkInterval) % aiOffScreenInterval].push_back(i);
+            overBudget = ai.thinkLimit > 0 && stats.thinks >= ai.thinkLimit;
+            if (!overBudget && ai.budgetMicroseconds > 0.0 && stats.thinks % 8 == 0) {
+                overBudget = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() > ai.budgetMicroseconds;
+            }
+        }
+        due.erase(due.begin(), due.begin() + done);
+        stats.deferred += (int)due.size();
+    }
+
+    stats.microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    stats.staleness = count > 0 ? ((double)count * ai.tick - (double)ai.lastThoughtSum) / count : 0.0;
+    stats.updates++;
+    stats.overruns += ai.budgetMicroseconds > 0.0 && stats.microseconds > ai.budgetMicroseconds;
+    stats.stalenessSum += stats.staleness;
+}
+
+void staggerEnemyThinking(std::vector<cube>& enemies) {
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        enemies[i].lastThought = 0;
+        enemies[i].thinkInterval = 1 + (int)(i % aiOffScreenInterval);
+    }
+}
+
+//---------------------------------------------------Methods to build structures---------------------------------------------------//
+void createCircularRoom(std::vector<wall>& levelPreset, Rng& rng, int centerX, int centerZ, int radius, float maxHeight, int doors) {
+    //creates a circular room with an entrance at radius on every side in doors (rooms.hpp)
+    for (int x = -radius; x <= radius; x++) {
+        for (int z = -radius; z <= radius; z++) {
+            bool door = (x >= -1 && x <= 1 && ((z == radius && (doors & doorPlusZ)) || (z == -radius && (doors & doorMinusZ)))) ||
+                (z >= -1 && z <= 1 && ((x == radius && (doors & doorPlusX)) || (x == -radius && (doors & doorMinusX))));
+            if ((x * x + z * z <= radius * radius) &&
+                (x * x + z * z > (radius - 1) * (radius - 1)) && !door) {
+                wall w = { (float)(centerX + x), (float)(centerZ + z), maxHeight };
+                w.h = (float)(randomInt(rng, 4) + 4);
+                levelPreset.push_back(w);
+            }
+        }
+    }
+}
+
+void createSquareRoom(std::vector<wall>& levelPreset, Rng& rng, int centerX, int centerZ, int roomSize, float maxHeight, int doors) {
+    //creates a square room with an entrance in the middle of every side in doors (rooms.hpp)
+    int half = roomSize / 2;
+    for (int x = -half; x <= half; x++) {
+        for (int z = -half; z <= half; z++) {
+            bool door = (x >= -1 && x <= 1 && ((z == half && (doors & doorPlusZ)) || (z == -half && (doors & doorMinusZ)))) ||
+                (z >= -1 && z <= 1 && ((x == half && (doors & doorPlusX)) || (x == -half && (doors & doorMinusX))));
+            if ((x == -half || x == half || z == -half || z == half) && !door) {
+                wall w = { (float)(centerX + x), (float)(centerZ + z), maxHeight };
+                w.h = (float)(randomInt(rng, 4) + 4);
+                levelPreset.push_back(w);
+            }
+        }
+    }
+}
+
+void createCross(std::vector<wall>& levelPreset, Rng& rng, int centerX, int centerZ, int armLength, float maxHeight) {
+    //creates a cross with a thickness of on and a designated arm length
+    for (int x = 0; x <= 0; x++) {
+        for (int z = -armLength; z <= armLength; z++) {
+            wall w = { (float)(centerX + x), (float)(centerZ + z), maxHeight };
+            w.h = (float)(randomInt(rng, 4) + 4);
+            levelPreset.push_back(w);
+        }
+    }
+
+    for (int z = 0; z <= 0; z++) {
+        for (int x = -armLength; x <= armLength; x++) {
+            if (true) {
+                wall w = { (float)(centerX + x), (float)(centerZ + z), maxHeight };
+                w.h = (float)(randomInt(rng, 4) + 4);
+                levelPreset.push_back(w);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------Methods that use the build methods to place structures and enemies---------------------------------------------------//
+std::vector<wall> generatelevel(float maxHeight, int level, Rng& rng, RoomGraph& rooms) {
+    std::vector<wall> levelPreset;
+    levelPreset.clear();
+    rooms = RoomGraph();
+
+    //the first level 
+    if (level == 1) {
+        //vectors that contain the x,z and size of the rooms {x, z, size}
+        std::vector<std::tuple<int, int, int>> squareRooms = {      
+            {-50, -50, 20}, {50, -50, 20}, {-50, 50, 20}, {50, 50, 20}, { 35, -15, 15}, { -20, 25, 12 }, { -40, -10, 18 },  { 30, 33, 8 }
+        };
+        std::vector<std::tuple<int, int, int>> roundRooms = {
+            {0, 0, 20}
+        };
+        std::vector<std::tuple<int, int, int>> cross = {
+            {0, 0, 10}
+        };
+        //creates the rooms
+        for (auto& pos : squareRooms) {
+            int firstWall = (int)levelPreset.size();
+            createSquareRoom(levelPreset, rng, std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), maxHeight, allDoors);
+            addSquareRoom(rooms, levelPreset, firstWall, std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), allDoors);
+        }
+
+        for (auto& pos : roundRooms) {
+            int firstWall = (int)levelPreset.size();
+            createCircularRoom(levelPreset, rng, std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), maxHeight, allDoors);
+            addRoundRoom(rooms, levelPreset, firstWall, std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), allDoors);
+        }
+        for (auto& pos : cross) {
+            createCross(levelPreset, rng, std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), maxHeight);
+        }
+
+        int smallRoomSize = 20;
+        int roomCenterX = 0;
+        int roomCenterZ = -50;
+        int firstWall = (int)levelPreset.size();
+        //player spawn room
+        for (int x = -smallRoomSize / 2; x <= smallRoomSize / 2; x++) {
+            for (int z = -smallRoomSize / 2; z <= smallRoomSize / 2; z++) {
+                if ((x == -smallRoomSize / 2 || x == smallRoomSize / 2 || z == -smallRoomSize / 2 || z == smallRoomSize / 2) &&
+                    !(x >= -1 && x <= 1 && z == smallRoomSize / 2)) { 
+                    wall w = { (float)(roomCenterX + x), (float)(roomCenterZ + z), maxHeight };
+                    levelPreset.push_back(w);
+                }
+            }
+        }
+        addSquareRoom(rooms, levelPreset, firstWall, roomCenterX, roomCenterZ, smallRoomSize, doorPlusZ);
+    }
+    //future levels would be added here
+    connectRooms(rooms, levelPreset);
+    return levelPreset;
+}
+
+std::vector<cube> distributeEnemies(int level, Rng& rng) {
+    std::vector<cube> enemies;
+    enemies.clear();
+    if (level == 1) {
+        std::vector<std::pair<float, float>> roomCenters = {        //contains the room coordinates
+            {-50, -50}, {50, -50}, {-50, 50}, {50, 50}, { 35, -15}, { -20, 25}, { -40, -10},  { 30, 33}  
+        };
+        //randomly places one or two enemies in each room
+        for (auto& center : roomCenters) {
+            int enemyCount = randomInt(rng, 2) + 1;  
+            for (int i = 0; i < enemyCount; i++) {
+                float x = center.first + static_cast<float>(randomInt(rng, 8) - 4);
+                float z = center.second + static_cast<float>(randomInt(rng, 8) - 4);
+                cube enemy = { x, z, 0.0f, 0.05f, 0.0f };
+                enemies.push_back(enemy);
+            }
+        }
+
+        //enemies in the circular room are placed here
+        cube enemy = { 14, 12, 0.0f, 0.05f, 0.0f };
+        enemies.push_back(enemy);
+        enemy = { -10,-8, 0.0f, 0.05f, 0.0f };
+        enemies.push_back(enemy);
+        enemy = { -4,3, 0.0f, 0.05f, 0.0f };
+        enemies.push_back(enemy);
+    }
+    return enemies;
+}
+
+//---------------------------------------------------Interpolation for rendering---------------------------------------------------//
+void storePreviousState(cube& c) {
+    c.prevX = c.x;
+    c.prevZ = c.z;
+    c.prevRotation = c.rotation;
+}
+
+cube interpolate(const cube& c, float alpha) {
+    cube shown = c;
+    shown.x = glm::mix(c.prevX, c.x, alpha);
+    shown.z = glm::mix(c.prevZ, c.z, alpha);
+    //enemy rotations jump between -180 and 180, so turn the short way around
+    shown.rotation = c.prevRotation + std::remainder(c.rotation - c.prevRotation, 360.0f) * alpha;
+    return shown;
+}
@@ -0,0 +1,114 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "bullets.hpp"
+#include "flowfield.hpp"
+#include "rng.hpp"
+#include "rooms.hpp"
+#include "wallgrid.hpp"
+
+//Game logic of the tanks game without any GL or GLFW, so it also runs headless.
+//The game and tanks_headless both drive it through simulateTick.
+
+const float bulletSpeed = 0.2f;                     //distance a bullet moves per update
+const int maxBullets = 16384;                       //size of the bullet pool, shots are dropped when it is full
+const double tickRate = 60.0;                       //simulation updates per second, all speeds are per update
+const float chaseStopDistance = 5.0f;               //enemies stop driving toward the player once they are this close
+
+//enemy thinking (aiming, line of sight and shooting) is spread over the updates by thinkEnemies
+const float aiNearDistance = 25.0f;                 //closer enemies think every update, farther ones less often the farther they are
+const float aiViewHalfAngle = 60.0f;                //degrees around the view direction that count as on screen, a bit wider than the game's view
+const float aiViewDistance = 100.0f;                //far plane of the game's camera
+const int aiOffScreenInterval = 12;                 //updates between the thinks of enemies out of view, 5 per second
+
+//Used for players and enemies
+struct cube {
+    float x, z;
+    float rotation;
+    float speed;
+    float lastShotTime = 0.0f;
+    float shootCooldown = 5.0f;
+    float prevX = 0.0f, prevZ = 0.0f;               //state before the last update, rendering blends between the two
+    float prevRotation = 0.0f;
+    int lastThought = 0;                            //AI update an enemy last thought in, see thinkEnemies
+    int thinkInterval = 1;                          //updates after that until it thinks again
+};
+
+//what the player does during one update, filled from the keyboard or by a bot
+struct TickInput {
+    bool turnLeft = false, turnRight = false;       //rotates playercube
+    bool forward = false, backward = false;
+    bool lookLeft = false, lookRight = false;       //turns the view independent of the cube
+    bool shoot = false;
+};
+
+struct AiStats {
+    int thinks = 0;                                 //in the last update
+    int lineOfSightTests = 0;
+    int reloading = 0;                              //thinks without a line of sight test, the enemy couldn't shoot anyway
+    int deferred = 0;                               //enemies that were due but wait for the next update, the budget was used up
+    double microseconds = 0.0;                      //spent thinking in the last update
+    double staleness = 0.0;                         //updates since the enemies last thought, averaged over them after the last update
+    int updates = 0;                                //since startGame
+    int overruns = 0;                               //updates that thought for longer than the budget
+    double stalenessSum = 0.0;                      //staleness of every update, / updates is the average
+};
+
+//when each enemy thinks next. Close ones think every update, the others when they are due and there is budget left.
+//An enemy waits in the wheel slot of the update it is due in, so an update only visits the enemies that are due.
+//Enemies are kept by index, the wheel is built again whenever the number of enemies changes
+struct AiScheduler {
+    double budgetMicroseconds = 0.0;                //per update, 0 for no limit. Without one a seed always plays the same match, with one it depends on the machine
+    int thinkLimit = 0;                             //thinks per update, 0 for no limit. Counted instead of timed, so a seed still plays the same match
+    int tick = 0;                                   //AI updates since startGame
+    std::vector<int> wheel[aiOffScreenInterval];    //enemies by the update they are due in, modulo aiOffScreenInterval
+    std::vector<int> due[2];                        //enemies due now that think every update and the others, the ones the budget left out first
+    int tracked = -1;                               //enemies the wheel holds, -1 builds it in the next update
+    int64_t lastThoughtSum = 0;                     //over all enemies, the staleness follows from it without visiting them
+    AiStats stats;
+};
+
+//everything one running game needs
+struct GameState {
+    cube player;
+    std::vector<cube> enemies;
+    std::vector<wall> walls;
+    WallGrid wallGrid;
+    RoomGraph rooms;                                //rooms and doors of the level, for culling what is hidden behind walls
+    FlowField chase;                                //leads every enemy to the player's cell, rebuilt when the player changes cells
+    FlowOccupancy crowd;                            //enemy in each cell of chase, no two enemies share a cell
+    AiScheduler ai;                                 //startGame keeps its budget
+    BulletPool bullets;
+    float platformSize = 120.0f;                    //Size of plattform 120x120
+    float cameraYaw = 0.0f;                         //view angle relative to the player, also the shooting angle
+    float prevCameraYaw = 0.0f;
+    bool isPlayerAlive = true;                      //used to end the game if player is hit
+    double time = 0.0;                              //simulation clock in seconds, advances 1 / tickRate per update
+    Rng rng;                                        //all randomness of this match, the same seed gives the same match
+};
+
+void startGame(GameState& game, int level, uint64_t seed, double startTime); //<<< builds the level, enemies, wall grid and bullet pool
+void simulateTick(GameState& game, const TickInput& input); //<<< one fixed update of input, bullets, collisions and enemies
+bool isGameOver(const GameState& game); //<<< player dead or all enemies gone
+
+void applyInput(GameState& game, const TickInput& input, float currentTime);
+void updateBullets(BulletPool& bullets, const std::vector<wall>& walls, const WallGrid& wallGrid, float platformSize, std::vector<cube>& enemies, cube player, bool& isPlayerAlive);
+void collideWithWalls(cube& tank, const std::vector<wall>& walls, const WallGrid& wallGrid, float platformSize); //<<< the player or an enemy, keeps it on the platform and out of the walls
+void moveEnemies(std::vector<cube>& enemies, const cube& player, const FlowField& chase, FlowOccupancy& crowd, const std::vector<wall>& walls, const WallGrid& wallGrid, float platformSize); //<<< enemies in neighbouring cells may still overlap a little across the cell border
+bool hasLineOfSight(cube enemy, cube player, const WallGrid& wallGrid);
+void thinkEnemies(AiScheduler& ai, std::vector<cube>& enemies, const cube& player, float cameraYaw, BulletPool& bullets, const WallGrid& wallGrid, float currentTime); //<<< the enemies that are due aim, and shoot if reloaded and the player is in sight
+void staggerEnemyThinking(std::vector<cube>& enemies); //<<< spreads their first thinks over aiOffScreenInterval updates, so the slow ones don't all think in the same update. Set AiScheduler::tracked to -1 after replacing the enemies
+
+void createCircularRoom(std::vector<wall>& levelPreset, Rng& rng, int centerX, int centerZ, int radius, float maxHeight, int doors); //<<< doors as in rooms.hpp, each a 3 wide gap where the circle crosses the axis
+void createSquareRoom(std::vector<wall>& levelPreset, Rng& rng, int centerX, int centerZ, int roomSize, float maxHeight, int doors); //<<< doors as in rooms.hpp, each a 3 wide gap in the middle of the side
+void createCross(std::vector<wall>& levelPreset, Rng& rng, int centerX, int centerZ, int armLength, float maxHeight);
+std::vector<wall> generatelevel(float maxHeight, int level, Rng& rng, RoomGraph& rooms);
+std::vector<cube> distributeEnemies(int level, Rng& rng);
+
+void storePreviousState(cube& c); //<<< remembers the current state as the previous one before an update
+cube interpolate(const cube& c, float alpha); //<<< blends previous and current state, alpha 0 is the previous update and 1 the latest
+
+#endif
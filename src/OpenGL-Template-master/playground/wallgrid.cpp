@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+
+#include "wallgrid.hpp"
+
+//world coordinate -> cell coordinate, cell k covers (k - 0.5, k + 0.5)
+static int cellOf(float v) {
+    return (int)std::floor(v + 0.5f);
+}
+
+WallGrid buildWallGrid(const std::vector<wall>& walls) {
+    WallGrid grid;
+    if (walls.empty()) {
+        return grid;
+    }
+
+    //the grid only spans the walls, so levels bigger than the platform work too
+    int maxX = cellOf(walls[0].x), maxZ = cellOf(walls[0].z);
+    grid.minX = maxX;
+    grid.minZ = maxZ;
+    for (const wall& w : walls) {
+        grid.minX = std::min(grid.minX, cellOf(w.x));
+        grid.minZ = std::min(grid.minZ, cellOf(w.z));
+        maxX = std::max(maxX, cellOf(w.x));
+        maxZ = std::max(maxZ, cellOf(w.z));
+    }
+    grid.width = maxX - grid.minX + 1;
+    grid.depth = maxZ - grid.minZ + 1;
+    grid.cells.assign(grid.width * grid.depth, -1);
+
+    //walls stacked on the same cell behave like the first one, so only that one is kept
+    for (int i = 0; i < (int)walls.size(); ++i) {
+        int& cell = grid.cells[(cellOf(walls[i].z) - grid.minZ) * grid.width + (cellOf(walls[i].x) - grid.minX)];
+        if (cell < 0) {
+            cell = i;
+        }
+    }
+    return grid;
+}
+
+int wallCellAt(const WallGrid& grid, int cellX, int cellZ) {
+    int gx = cellX - grid.minX;
+    int gz = cellZ - grid.minZ;
+    if (gx < 0 || gz < 0 || gx >= grid.width || gz >= grid.depth) {
+        return -1;
+    }
+    return grid.cells[gz * grid.width + gx];
+}
+
+int wallAtPoint(const WallGrid& grid, const std::vector<wall>& walls, float x, float z) {
+    int i = wallCellAt(grid, cellOf(x), cellOf(z));
+    if (i < 0) {
+        return -1;
+    }
+    //same open-interval test the old loop over all walls used, points on a wall edge don't count
+    const wall& w = walls[i];
+    if (x > w.x - 0.5f && x < w.x + 0.5f && z > w.z - 0.5f && z < w.z + 0.5f) {
+        return i;
+    }
+    return -1;
+}
+
+int wallsNear(const WallGrid& grid, float x, float z, int range, int* out, int maxOut) {
+    int cx = cellOf(x);
+    int cz = cellOf(z);
+    int count = 0;
+    for (int gz = cz - range; gz <= cz + range; ++gz) {
+        for (int gx = cx - range; gx <= cx + range; ++gx) {
+            int i = wallCellAt(grid, gx, gz);
+            if (i >= 0 && count < maxOut) {
+                out[count++] = i;
+            }
+        }
+    }
+    //callers resolve collisions in wall list order, the same order the old full scan used
+    std::sort(out, out + count);
+    return count;
+}
+
+//Grid traversal after Amanatides & Woo: walks the cells crossed by the segment in order,
+//every cell exactly once, and stops at the first one that holds a wall.
+RayHit raycastWalls(const WallGrid& grid, float fromX, float fromZ, float toX, float toZ) {
+    RayHit result;
+    float dx = toX - fromX;
+    float dz = toZ - fromZ;
+    float length = std::sqrt(dx * dx + dz * dz);
+    if (length <= 0.0f) {
+        return result;
+    }
+    dx /= length;
+    dz /= length;
+
+    int cellX = cellOf(fromX);
+    int cellZ = cellOf(fromZ);
+    int stepX = dx > 0.0f ? 1 : -1;
+    int stepZ = dz > 0.0f ? 1 : -1;
+
+    //distance along the ray to the next cell border in x and z, and between two borders
+    const float infinity = 1e30f;
+    float tMaxX = dx != 0.0f ? ((cellX + 0.5f * stepX) - fromX) / dx : infinity;
+    float tMaxZ = dz != 0.0f ? ((cellZ + 0.5f * stepZ) - fromZ) / dz : infinity;
+    float tDeltaX = dx != 0.0f ? 1.0f / std::abs(dx) : infinity;
+    float tDeltaZ = dz != 0.0f ? 1.0f / std::abs(dz) : infinity;
+
+    //the start cell is where the shooter stands, it is never checked
+    while (true) {
+        float t = std::min(tMaxX, tMaxZ);
+        if (t >= length) {
+            return result;
+        }
+
+        if (tMaxX == tMaxZ) {
+            //exactly through a corner, the two side cells count as touched so diagonal walls don't leak
+            int side = wallCellAt(grid, cellX + stepX, cellZ);
+            int sideX = cellX + stepX, sideZ = cellZ;
+            if (side < 0) {
+                side = wallCellAt(grid, cellX, cellZ + stepZ);
+                sideX = cellX;
+                sideZ = cellZ + stepZ;
+            }
+            if (side >= 0) {
+                result.hit = true;
+                result.distance = t;
+                result.cellX = sideX;
+                result.cellZ = sideZ;
+                result.wallIndex = side;
+                return result;
+            }
+            cellX += stepX;
+            cellZ += stepZ;
+            tMaxX += tDeltaX;
+            tMaxZ += tDeltaZ;
+        }
+        else if (tMaxX < tMaxZ) {
+            cellX += stepX;
+            tMaxX += tDeltaX;
+        }
+        else {
+            cellZ += stepZ;
+            tMaxZ += tDeltaZ;
+        }
+
+        int i = wallCellAt(grid, cellX, cellZ);
+        if (i >= 0) {
+            result.hit = true;
+            result.distance = t;
+            result.cellX = cellX;
+            result.cellZ = cellZ;
+            result.wallIndex = i;
+            return result;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef WALLGRID_HPP
+#define WALLGRID_HPP
+
+#include <vector>
+
+//for the walls
+struct wall {
+    float x, z, h;
+};
+
+//Cell index over the walls. generatelevel only places walls on integer coordinates,
+//so every wall fills exactly one 1x1 cell and a query only has to look at the cells it touches.
+struct WallGrid {
+    int minX = 0, minZ = 0;                         //world coordinate of cell (0,0)
+    int width = 0, depth = 0;                       //number of cells in x and z
+    std::vector<int> cells;                         //index of the first wall in each cell, -1 if the cell is empty
+};
+
+//result of a ray cast through the wall grid
+struct RayHit {
+    bool hit = false;
+    float distance = 0.0f;                          //distance from the ray start to where it enters the wall cell
+    int cellX = 0, cellZ = 0;                       //cell of the wall that was hit
+    int wallIndex = -1;
+};
+
+WallGrid buildWallGrid(const std::vector<wall>& walls);   //<<< built once after setupGame, walls must not move afterwards
+int wallCellAt(const WallGrid& grid, int cellX, int cellZ); //<<< wall index in the cell or -1 (also for cells outside the grid)
+int wallAtPoint(const WallGrid& grid, const std::vector<wall>& walls, float x, float z); //<<< wall whose square contains the point or -1
+int wallsNear(const WallGrid& grid, float x, float z, int range, int* out, int maxOut); //<<< wall indices within +-range cells, sorted like the wall list
+RayHit raycastWalls(const WallGrid& grid, float fromX, float fromZ, float toX, float toZ); //<<< first wall cell crossed between the two points, the start cell is skipped
+
+#endif
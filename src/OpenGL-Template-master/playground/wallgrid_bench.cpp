@@ -0,0 +1,180 @@
+//Benchmark for the wall grid: runs the wall queries of one game tick (bullets, player collision,
+//line of sight for 19 enemies) once with the grid and once with the old scan over all walls.
+//The arena grows with the wall count so the wall density stays like level 1.
+//The second table compares the old stepped line of sight with the grid ray cast on level 1 itself: its walls and
+//enemies from startGame, a seed that gives every room two enemies (19), and the player on random free cells.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "simulation.hpp"
+#include "wallgrid.hpp"
+
+struct point {
+    float x, z;
+};
+
+//old versions, loop over every wall
+static int scanWallAtPoint(const std::vector<wall>& walls, float x, float z) {
+    for (int i = 0; i < (int)walls.size(); ++i) {
+        const wall& w = walls[i];
+        if (x > w.x - 0.5f && x < w.x + 0.5f && z > w.z - 0.5f && z < w.z + 0.5f) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool scanLineOfSight(const std::vector<wall>& walls, point from, point to) {
+    float dx = to.x - from.x, dz = to.z - from.z;
+    float distance = std::sqrt(dx * dx + dz * dz);
+    float step = 0.5f;
+    for (float t = step; t < distance + step; t += step) {
+        float px = from.x + dx / distance * t, pz = from.z + dz / distance * t;
+        for (const wall& w : walls) {
+            if ((px - w.x) * (px - w.x) + (pz - w.z) * (pz - w.z) < 0.25f) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//exact reference, segment against the open square of every wall (slab test)
+static bool exactLineOfSight(const std::vector<wall>& walls, point from, point to) {
+    float dx = to.x - from.x, dz = to.z - from.z;
+    for (const wall& w : walls) {
+        //the shooter's own cell is skipped by the ray cast as well
+        if (std::floor(from.x + 0.5f) == w.x && std::floor(from.z + 0.5f) == w.z) continue;
+        float tMin = 0.0f, tMax = 1.0f;
+        float origin[2] = { from.x - w.x, from.z - w.z };
+        float dir[2] = { dx, dz };
+        bool inside = true;
+        for (int axis = 0; axis < 2 && inside; ++axis) {
+            if (dir[axis] == 0.0f) {
+                inside = std::abs(origin[axis]) < 0.5f;
+                continue;
+            }
+            float t0 = (-0.5f - origin[axis]) / dir[axis], t1 = (0.5f - origin[axis]) / dir[axis];
+            tMin = std::max(tMin, std::min(t0, t1));
+            tMax = std::min(tMax, std::max(t0, t1));
+            inside = tMin < tMax;
+        }
+        if (inside) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//new versions, only the touched cells
+static bool gridLineOfSight(const WallGrid& grid, const std::vector<wall>& walls, point from, point to) {
+    float dx = to.x - from.x, dz = to.z - from.z;
+    float distance = std::sqrt(dx * dx + dz * dz);
+    float step = 0.5f;
+    for (float t = step; t < distance + step; t += step) {
+        float px = from.x + dx / distance * t, pz = from.z + dz / distance * t;
+        int i = wallAtPoint(grid, walls, px, pz);
+        if (i >= 0 && (px - walls[i].x) * (px - walls[i].x) + (pz - walls[i].z) * (pz - walls[i].z) < 0.25f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static float randomCoord(int half) {
+    return (float)(std::rand() % (2 * half * 100)) / 100.0f - half;
+}
+
+int main() {
+    const int bulletCount = 200;
+    const int enemyCount = 19;
+    const int ticks = 20;
+    int wallCounts[] = { 1000, 10000, 100000 };
+
+    printf("%8s %8s %14s %14s %8s\n", "walls", "arena", "grid us/tick", "scan us/tick", "equal");
+    for (int wallCount : wallCounts) {
+        std::srand(1);
+        //level 1 fills about 7% of the 120x120 platform with walls
+        int half = (int)(std::sqrt(wallCount / 0.07f) / 2.0f);
+        std::vector<wall> walls;
+        for (int i = 0; i < wallCount; ++i) {
+            walls.push_back({ (float)(std::rand() % (2 * half) - half), (float)(std::rand() % (2 * half) - half), 5.0f });
+        }
+        WallGrid grid = buildWallGrid(walls);
+
+        std::vector<point> bullets(bulletCount), enemies(enemyCount);
+        for (point& b : bullets) b = { randomCoord(half), randomCoord(half) };
+        for (point& e : enemies) e = { randomCoord(20), randomCoord(20) };
+        point player = { 0.0f, 0.0f };
+
+        bool equal = true;
+        long long gridHits = 0, scanHits = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; ++t) {
+            for (const point& b : bullets) gridHits += wallAtPoint(grid, walls, b.x, b.z) >= 0;
+            int nearby[25];
+            gridHits += wallsNear(grid, player.x, player.z, 2, nearby, 25);
+            for (const point& e : enemies) gridHits += gridLineOfSight(grid, walls, e, player);
+        }
+        double gridTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ticks;
+
+        start = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; ++t) {
+            for (const point& b : bullets) scanHits += scanWallAtPoint(walls, b.x, b.z) >= 0;
+            for (const wall& w : walls) scanHits += std::abs(player.x - w.x) < 2.5f && std::abs(player.z - w.z) < 2.5f;
+            for (const point& e : enemies) scanHits += scanLineOfSight(walls, e, player);
+        }
+        double scanTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ticks;
+
+        //duplicate walls on one cell are counted once by the grid, so only compare the single hit queries
+        for (const point& b : bullets) equal &= (wallAtPoint(grid, walls, b.x, b.z) >= 0) == (scanWallAtPoint(walls, b.x, b.z) >= 0);
+        for (const point& e : enemies) equal &= gridLineOfSight(grid, walls, e, player) == scanLineOfSight(walls, e, player);
+
+        printf("%8d %8d %14.1f %14.1f %8s\n", wallCount, 2 * half, gridTime, scanTime, equal ? "yes" : "NO");
+    }
+
+    //line of sight on level 1, the first seed with two enemies in every room
+    GameState game;
+    unsigned seed = 1;
+    do {
+        startGame(game, 1, seed++, 0.0);
+    } while (game.enemies.size() < 19);
+    const std::vector<wall>& walls = game.walls;
+    const WallGrid& grid = game.wallGrid;
+    const int rounds = 1000;
+    std::vector<point> enemies, players;
+    for (const cube& enemy : game.enemies) enemies.push_back({ enemy.x, enemy.z });
+    std::srand(2);
+    while ((int)players.size() < rounds) {
+        point p = { randomCoord(59), randomCoord(59) };
+        if (wallCellAt(grid, (int)std::floor(p.x + 0.5f), (int)std::floor(p.z + 0.5f)) < 0) players.push_back(p);
+    }
+    int stepMisses = 0, rayMismatches = 0, stepVisible = 0, visible = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const point& p : players) for (const point& e : enemies) stepVisible += scanLineOfSight(walls, e, p);
+    double stepTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+    start = std::chrono::steady_clock::now();
+    for (const point& p : players) for (const point& e : enemies) visible += !raycastWalls(grid, e.x, e.z, p.x, p.z).hit;
+    double rayTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+    for (const point& p : players) {
+        for (const point& e : enemies) {
+            bool exact = exactLineOfSight(walls, e, p);
+            stepMisses += scanLineOfSight(walls, e, p) != exact;
+            rayMismatches += !raycastWalls(grid, e.x, e.z, p.x, p.z).hit != exact;
+        }
+    }
+    printf("\nline of sight on level 1 seed %u, %d enemies, %d walls, %d of %d pairs visible (stepped: %d)\n", seed - 1, (int)enemies.size(), (int)walls.size(), visible,
+           rounds * (int)enemies.size(), stepVisible);
+    printf("%14s %14s %8s\n", "", "us/tick", "wrong");
+    printf("%14s %14.1f %8d\n", "stepped scan", stepTime, stepMisses);
+    printf("%14s %14.1f %8d\n", "ray cast", rayTime, rayMismatches);
+    printf("ray cast %.1fx faster\n", stepTime / rayTime);
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cmath>
+
+#include "wallmesh.hpp"
+
+//world coordinate -> cell coordinate, cell k covers (k - 0.5, k + 0.5), same as the wall grid
+static int cellOf(float v) {
+    return (int)std::floor(v + 0.5f);
+}
+
+//corners go around the quad, the order is flipped if needed so the front faces along normal
+static void addQuad(WallMesh& mesh, const float corners[4][3], const float normal[3]) {
+    float e1[3], e2[3];
+    for (int i = 0; i < 3; ++i) {
+        e1[i] = corners[1][i] - corners[0][i];
+        e2[i] = corners[2][i] - corners[0][i];
+    }
+    float facing = (e1[1] * e2[2] - e1[2] * e2[1]) * normal[0]
+                 + (e1[2] * e2[0] - e1[0] * e2[2]) * normal[1]
+                 + (e1[0] * e2[1] - e1[1] * e2[0]) * normal[2];
+    static const int forward[4] = { 0, 1, 2, 3 };
+    static const int backward[4] = { 0, 3, 2, 1 };
+    const int* order = facing >= 0.0f ? forward : backward;
+
+    unsigned int first = (unsigned int)(mesh.positions.size() / 3);
+    for (int i = 0; i < 4; ++i) {
+        mesh.positions.insert(mesh.positions.end(), corners[order[i]], corners[order[i]] + 3);
+        mesh.normals.insert(mesh.normals.end(), normal, normal + 3);
+    }
+    unsigned int quad[6] = { first, first + 1, first + 2, first + 2, first + 3, first };
+    mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+    mesh.quads++;
+}
+
+//the walls as a grid of column heights, 0 where there is no wall
+struct HeightField {
+    int minX, minZ;                                 //world coordinate of cell (0,0)
+    int width, depth;
+    std::vector<float> heights;
+    std::vector<int> regions;                       //region of the highest wall in the cell, -1 where there is none
+
+    float at(int gx, int gz) const { return heights[gz * width + gx]; }
+    int regionAt(int gx, int gz) const { return regions[gz * width + gx]; }
+};
+
+//cells [x0, x1) x [z0, z1) holding walls of one region
+struct RegionBox {
+    int x0, z0, x1, z1;
+};
+
+//tops and sides of the region's columns in cells [gx0, gx1) x [gz0, gz1), faces are only merged inside these cells.
+//Neighbours are looked up in the whole field, so a face against a wall of another region is hidden as well
+static void bakeCells(WallMesh& mesh, const HeightField& field, std::vector<char>& covered, int region, int gx0, int gz0, int gx1, int gz1) {
+    int width = field.width;
+
+    //tops: grow a rectangle of equal height cells in x, then row by row in z
+    const float up[3] = { 0.0f, 1.0f, 0.0f };
+    for (int gz = gz0; gz < gz1; ++gz) {
+        for (int gx = gx0; gx < gx1; ++gx) {
+            float h = field.at(gx, gz);
+            if (h <= 0.0f || field.regionAt(gx, gz) != region || covered[gz * width + gx]) {
+                continue;
+            }
+            auto fits = [&](int x, int z) { return field.at(x, z) == h && field.regionAt(x, z) == region && !covered[z * width + x]; };
+            int endX = gx + 1;
+            while (endX < gx1 && fits(endX, gz)) {
+                endX++;
+            }
+            int endZ = gz + 1;
+            while (endZ < gz1) {
+                bool rowFits = true;
+                for (int x = gx; x < endX && rowFits; ++x) {
+                    rowFits = fits(x, endZ);
+                }
+                if (!rowFits) {
+                    break;
+                }
+                endZ++;
+            }
+            for (int z = gz; z < endZ; ++z) {
+                std::fill(covered.begin() + z * width + gx, covered.begin() + z * width + endX, 1);
+            }
+
+            float x0 = field.minX + gx - 0.5f, x1 = field.minX + endX - 0.5f;
+            float z0 = field.minZ + gz - 0.5f, z1 = field.minZ + endZ - 0.5f;
+            const float corners[4][3] = { { x0, h, z0 }, { x0, h, z1 }, { x1, h, z1 }, { x1, h, z0 } };
+            addQuad(mesh, corners, up);
+        }
+    }
+
+    //sides: a wall only shows the part that sticks out above its neighbour in that direction,
+    //runs of cells along the same plane showing the same part become one quad.
+    //Bottoms lie on the platform and are never visible, so there are none.
+    const int directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    for (const auto& direction : directions) {
+        int dx = direction[0], dz = direction[1];
+        bool facesX = dx != 0;                      //faces pointing along x line up along z and the other way round
+        int lineBegin = facesX ? gx0 : gz0, lineEnd = facesX ? gx1 : gz1;
+        int runBegin = facesX ? gz0 : gx0, runEnd = facesX ? gz1 : gx1;
+        const float normal[3] = { (float)dx, 0.0f, (float)dz };
+
+        for (int line = lineBegin; line < lineEnd; ++line) {
+            int runStart = -1;
+            float runLow = 0.0f, runHigh = 0.0f;
+            for (int i = runBegin; i <= runEnd; ++i) {
+                float low = 0.0f, high = 0.0f;
+                if (i < runEnd) {
+                    int gx = facesX ? line : i;
+                    int gz = facesX ? i : line;
+                    float h = field.at(gx, gz);
+                    if (h > 0.0f && field.regionAt(gx, gz) == region) {
+                        float neighbour = field.at(gx + dx, gz + dz);
+                        if (h > neighbour) {
+                            low = neighbour;
+                            high = h;
+                        }
+                    }
+                }
+
+                if (runStart >= 0 && (low != runLow || high != runHigh)) {
+                    float plane = (facesX ? field.minX : field.minZ) + line + 0.5f * (dx + dz);
+                    float a = (facesX ? field.minZ : field.minX) + runStart - 0.5f;
+                    float b = (facesX ? field.minZ : field.minX) + i - 0.5f;
+                    if (facesX) {
+                        const float corners[4][3] = { { plane, runLow, a }, { plane, runLow, b }, { plane, runHigh, b }, { plane, runHigh, a } };
+                        addQuad(mesh, corners, normal);
+                    }
+                    else {
+                        const float corners[4][3] = { { a, runLow, plane }, { b, runLow, plane }, { b, runHigh, plane }, { a, runHigh, plane } };
+                        addQuad(mesh, corners, normal);
+                    }
+                    runStart = -1;
+                }
+                if (runStart < 0 && high > low) {
+                    runStart = i;
+                    runLow = low;
+                    runHigh = high;
+                }
+            }
+        }
+    }
+}
+
+WallMesh bakeWallMesh(const std::vector<wall>& walls) {
+    return bakeWallMesh(walls, std::vector<int>(walls.size(), 0));
+}
+
+WallMesh bakeWallMesh(const std::vector<wall>& walls, const std::vector<int>& regions) {
+    WallMesh mesh;
+    if (walls.empty()) {
+        return mesh;
+    }
+
+    //one height field over all walls with an empty border, so every neighbour of a wall cell is inside.
+    //Walls stacked on one cell are a single column as high as the highest of them.
+    int maxX = cellOf(walls[0].x), maxZ = cellOf(walls[0].z);
+    HeightField field;
+    field.minX = maxX;
+    field.minZ = maxZ;
+    int regionCount = 0;
+    for (size_t i = 0; i < walls.size(); ++i) {
+        field.minX = std::min(field.minX, cellOf(walls[i].x));
+        field.minZ = std::min(field.minZ, cellOf(walls[i].z));
+        maxX = std::max(maxX, cellOf(walls[i].x));
+        maxZ = std::max(maxZ, cellOf(walls[i].z));
+        regionCount = std::max(regionCount, regions[i] + 1);
+    }
+    field.minX--;
+    field.minZ--;
+    field.width = maxX - field.minX + 2;
+    field.depth = maxZ - field.minZ + 2;
+    field.heights.assign(field.width * field.depth, 0.0f);
+    field.regions.assign(field.width * field.depth, -1);
+
+    //the cells every region covers, collected in the same pass that fills the field
+    std::vector<RegionBox> boxes(regionCount, { field.width, field.depth, 0, 0 });
+    for (size_t i = 0; i < walls.size(); ++i) {
+        int gx = cellOf(walls[i].x) - field.minX, gz = cellOf(walls[i].z) - field.minZ;
+        int cell = gz * field.width + gx;
+        if (walls[i].h > field.heights[cell]) {
+            field.heights[cell] = walls[i].h;
+            field.regions[cell] = regions[i];
+        }
+        RegionBox& box = boxes[regions[i]];
+        box.x0 = std::min(box.x0, gx);
+        box.z0 = std::min(box.z0, gz);
+        box.x1 = std::max(box.x1, gx + 1);
+        box.z1 = std::max(box.z1, gz + 1);
+    }
+
+    //every chunk is a contiguous index range of one region with its own bounding box, so it can be culled on its own
+    std::vector<char> covered(field.width * field.depth, 0);
+    for (int region = 0; region < regionCount; ++region) {
+        const RegionBox& box = boxes[region];
+        for (int gz = box.z0; gz < box.z1; gz += wallChunkSize) {
+            for (int gx = box.x0; gx < box.x1; gx += wallChunkSize) {
+                WallChunk chunk;
+                chunk.region = region;
+                chunk.firstIndex = (int)mesh.indices.size();
+                size_t firstVertex = mesh.positions.size() / 3;
+                bakeCells(mesh, field, covered, region, gx, gz, std::min(gx + wallChunkSize, box.x1), std::min(gz + wallChunkSize, box.z1));
+                chunk.indexCount = (int)mesh.indices.size() - chunk.firstIndex;
+                if (chunk.indexCount == 0) {
+                    continue;
+                }
+                for (int axis = 0; axis < 3; ++axis) {
+                    chunk.boxMin[axis] = chunk.boxMax[axis] = mesh.positions[firstVertex * 3 + axis];
+                }
+                for (size_t v = firstVertex; v < mesh.positions.size() / 3; ++v) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        chunk.boxMin[axis] = std::min(chunk.boxMin[axis], mesh.positions[v * 3 + axis]);
+                        chunk.boxMax[axis] = std::max(chunk.boxMax[axis], mesh.positions[v * 3 + axis]);
+                    }
+                }
+                mesh.chunks.push_back(chunk);
+            }
+        }
+    }
+    return mesh;
+}
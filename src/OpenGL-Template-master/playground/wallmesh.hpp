@@ -0,0 +1,30 @@
+#ifndef WALLMESH_HPP
+#define WALLMESH_HPP
+
+#include <vector>
+
+#include "wallgrid.hpp"
+
+const int wallChunkSize = 16;                       //cells per side of a chunk, the unit the culling works with
+
+//part of the wall mesh over wallChunkSize x wallChunkSize cells
+struct WallChunk {
+    int firstIndex = 0, indexCount = 0;             //range in WallMesh::indices
+    int region = 0;                                 //group of walls the chunk was baked from
+    float boxMin[3], boxMax[3];                     //bounding box of the chunk's faces
+};
+
+//All walls of a level baked into one static triangle mesh. Walls never move after the pregame,
+//so the mesh is built once and drawn with a single call instead of one cube per wall.
+struct WallMesh {
+    std::vector<float> positions;                   //x, y, z per vertex, 4 vertices per quad
+    std::vector<float> normals;                     //x, y, z per vertex, the normal of its face
+    std::vector<unsigned int> indices;              //2 triangles per quad, counter clockwise seen from outside
+    int quads = 0;
+    std::vector<WallChunk> chunks;                  //in index order, chunks without faces are left out
+};
+
+WallMesh bakeWallMesh(const std::vector<wall>& walls); //<<< only visible faces, touching walls share no faces and neighbouring faces of the same height are merged within a chunk
+WallMesh bakeWallMesh(const std::vector<wall>& walls, const std::vector<int>& regions); //<<< same faces, split into chunks that only hold walls of one region (regions[i] >= 0 for wall i)
+
+#endif